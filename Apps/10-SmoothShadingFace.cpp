@@ -1,279 +1,546 @@
-// Original: FacetedGouraud.cpp (c) Jules Bloomenthal 2020, all rights reserved
-// Modified: SmoothShadingFace.cpp by Edward Lam
-
-#include <glad.h>
-#include <GLFW/glfw3.h>
-#include <stdio.h>
-#include <vector>
-#include "Camera.h"
-#include "Draw.h"
-#include "GLXtras.h"
-#include "VecMat.h"
-#include "Widgets.h"
-#include <float.h>
-using namespace std;
-
-
-// vertex buffer, shader program ids
-GLuint vBuffer = 0, progFaceted = 0;
-
-// display parameters
-int screenWidth = 900, screenHeight = 900;
-Camera camera(screenWidth, screenHeight, vec3(0, 0, 0), vec3(0, 0, -20), 30);
-    // respond to mouse events, half screen size, set back on z-axis, with fov of 30
-
-// interaction
-vec3 light(1.1f, 1.7f, -1.2f);
-Mover lightMover;
-void *picked = NULL;
-
-
-
-// Shaders
-
-const char* vertexShader = R"(
-    #version 130
-    in vec3 point;
-    in vec3 normal;
-    in vec3 color;
-    out vec3 vPoint;
-    out vec3  vNormal;
-    uniform mat4 persp;
-    uniform mat4 modelview;
-    void main() {
-        vPoint = (modelview*vec4(point,1)).xyz;
-        vNormal = (modelview*vec4(normal,0)).xyz;
-        gl_Position = persp*vec4(vPoint, 1);
-    }
-)";
-
-const char* pixelShader = R"(
-    #version 130
-    uniform float a = .2;
-    in vec3 vPoint;
-    in vec3 vNormal;
-    out vec4 pColor;
-
-    uniform vec3 lightPos = vec3(1,0,0);
-
-    uniform vec3 color = vec3(1,1,1);
-
-    vec3 N = normalize(vNormal);
-
-    vec3 L = normalize(lightPos-vPoint);
-
-    float d = abs(dot(N,L));
-
-    vec3 R = reflect(L,N);
-
-    vec3 E = normalize(vPoint);
-
-    void main() {
-        float h = max(0, dot(R,E));
-        float s = pow(h, 100);
-        float intensity = clamp(a+d+s, 0, 1);
-        pColor = vec4(intensity*color, 1);
-    }
-)";
-
-
-
-// Mouse
-
-bool Shift(GLFWwindow *w) {
-    return glfwGetKey(w, GLFW_KEY_LEFT_SHIFT) == GLFW_PRESS ||
-           glfwGetKey(w, GLFW_KEY_RIGHT_SHIFT) == GLFW_PRESS;
-}
-
-int WindowHeight(GLFWwindow *w) {
-    int width, height;
-    glfwGetWindowSize(w, &width, &height);
-    return height;
-}
-
-void MouseButton(GLFWwindow *w, int butn, int action, int mods) {
-    double x, y;
-    glfwGetCursorPos(w, &x, &y);
-	y = WindowHeight(w)-y;
-    picked = NULL;
-    if (action == GLFW_PRESS) {
-        if (MouseOver(x, y, light, camera.fullview, 20)) {
-			picked = &lightMover;
-            lightMover.Down(&light, (int) x, (int) y, camera.modelview, camera.persp);
-        }
-        if (picked == NULL) {
-            picked = &camera;
-            camera.MouseDown((int) x, (int) y);
-        }
-    }
-    if (action == GLFW_RELEASE)
-        camera.MouseUp();
-}
-
-void MouseMove(GLFWwindow *w, double x, double y) {
-	y = WindowHeight(w)-y;
-    if (glfwGetMouseButton(w, GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS) {
-        if (picked == &lightMover)
-            lightMover.Drag((int) x, (int) y, camera.modelview, camera.persp);
-        else
-            camera.MouseDrag(x, y, Shift(w));
-    }
-}
-
-void MouseWheel(GLFWwindow *w, double ignore, double spin) {
-    camera.MouseWheel(spin > 0, Shift(w));
-}
-
-// Vertex Buffer
-
-struct Vertex {
-    vec3 point, color, normal;
-    Vertex() { }
-    Vertex(vec3 p, vec3 c, vec3 n) : point(p), color(c), normal(n) { }
-};
-
-int triangles[][3] = { 
-    //triangles -- index starts from 0
-    {0,1,11},{1,11,12},{1,2,12},{2,12,13},{12,13,14},{13,14,16},{13,15,16},{2,3,13},{3,13,15},
-    {3,4,15},{4,15,17},{15,17,18},{15,18,19},{15,16,19},{14,16,24},{16,19,24},{18,19,23},{19,23,24},
-    {18,21,23},{20,21,22},{4,17,20},{4,20,22},{4,22,32},{4,32,5},{21,22,23},{23,24,28},{22,23,28},
-    {22,27,28},{32,26,22},{22,26,27},{5,32,25},{5,25,6},{6,25,26},{6,26,27},{6,27,7},{7,27,8},
-    {8,27,29},{27,29,30},{27,28,30},{30,28,31},{30,10,31},{9,30,10}
-};
-
-vec3 points[] = {
-    vec3(0,.85f,.19f),vec3(0,.7f,.25f),vec3(0,.45f,.3f),vec3(0,.35f,.3f),                           //1-4
-    vec3(0,-.2f,.45f),vec3(0,-.1f,.52f),vec3(0,-.2f,.35f),vec3(0,-.3f,.4f),                         //5-8
-    vec3(0,-.4f,.4f), vec3(0, -.5f, .35f), vec3(0,-.85f, .22f), vec3(.4f,.8f,.05f),                 //9-12
-    vec3(.55f,.65f,-.1f),vec3(.51f,.5f,-.1f),vec3(.68f,.49f,-.2f),vec3(.35f,-.2f,.2f),              //13-16
-    vec3(.59f,.37f,-.1f),vec3(.24f,.26f,.28f),vec3(.49f,.21f,-.01f),vec3(.55f,.21f,-.01f),          //17-20
-    vec3(.18f,.2f,.3f),vec3(.36f,.15f,.2f),vec3(.3f,.5f,.2f),vec3(.48f,.01f,.08f),                  //21-24
-    vec3(.68f,-.01f,-.33f),vec3(.1f,-.1f,.25f),vec3(.18f,-.13f,-.25f),vec3(.2f,-.2f,.29f),          //25-28
-    vec3(.55f,-.35f,-.49f),vec3(.1f,-.41f,.29f),vec3(.28f,-.47f,.23f),vec3(.35f,-.78f,-.2f),        //29-32
-    vec3(.12f,-.01f,.33f),                                                                          //33 Missed in middle
-
-};
-
-// declare array of normals, one for each point
-const int npoints = sizeof(points) / sizeof(int);
-vec3 normals[npoints];
-int sizePts;
-
-void InitVertexBuffer() {
-    // create GPU buffer to hold positions and colors, and make it the active buffer
-    glGenBuffers(1, &vBuffer);
-    glBindBuffer(GL_ARRAY_BUFFER, vBuffer);
-    // allocate memory for vertex positions and colors
-    int sizePts = sizeof(points), sizeNms = sizeof(normals);
-    glBufferData(GL_ARRAY_BUFFER, sizePts + sizeNms, NULL, GL_STATIC_DRAW);
-    // load data to sub-buffers
-    glBufferSubData(GL_ARRAY_BUFFER, 0, sizePts, &points[0]);
-    glBufferSubData(GL_ARRAY_BUFFER, sizePts, sizeNms, &normals[0]);
-}
-
-// Display
-
-void Display(GLFWwindow *w) {
-    
-
-    // clear screen, enable z-buffer
-    glClearColor(.5, .5, .5, 1);
-    glClear(GL_COLOR_BUFFER_BIT);
-    glClear(GL_DEPTH_BUFFER_BIT);
-    glEnable(GL_DEPTH_TEST);
-	glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-    glUseProgram(progFaceted);
-    glBindBuffer(GL_ARRAY_BUFFER, vBuffer);
-
-    VertexAttribPointer(progFaceted, "point", 3, 0, (void*)0);
-    VertexAttribPointer(progFaceted, "normal", 3, 0, (void*)sizePts);
-
-
-    SetUniform(progFaceted, "modelview", camera.modelview);
-    SetUniform(progFaceted, "persp", camera.persp);
-    SetUniform(progFaceted, "lightPos", light);
-    glDrawElements(GL_TRIANGLES, sizeof(triangles) / sizeof(int), GL_UNSIGNED_INT, triangles);
-    // draw light
-    UseDrawShader(camera.fullview);
-    glDisable(GL_DEPTH_TEST);
-    bool visible = IsVisible(light, camera.fullview);
-    bool incube = fabs(light.x) < 1 && fabs(light.y) < 1 && fabs(light.z) < 1;
-    Disk(light, 12, incube? vec3(0,0,1) : vec3(1,0,0), visible? 1 : .25f);
-    glFlush();
-}
-
-// Application
-
-const char *usage = "Usage\n\
-    mouse-drag:\t\trotate x,y\n\
-    with shift:\t\ttranslate x,y\n\
-    mouse-wheel:\trotate/translate z\n";
-
-void Resize(GLFWwindow *w, int width, int height) {
-    camera.Resize(width, height);
-    glViewport(0, 0, screenWidth = width, screenHeight = height);
-}
-
-void Normalize() {
-    int npoints = sizeof(points) / sizeof(vec3);
-    // scale and offset so that points all within +/-1 in x, y , and z
-    vec3 mn(FLT_MAX), mx(-FLT_MAX);
-    for (int i = 0; i < npoints; i++) {
-        vec3 p = points[i];
-        for (int k = 0; k < 3; k++) {
-            if (p[k] < mn[k]) mn[k] = p[k];
-            if (p[k] < mx[k]) mx[k] = p[k];
-        }
-    }
-    vec3 center = .5f * (mn + mx), range = mx - mn;
-    float maxrange = max(range.x, max(range.y, range.z));
-    float s = 2 / maxrange;
-    for (int i = 0; i < npoints; i++)
-        points[i] = s * (points[i] - center);
-}
-
-
-int main(int ac, char **av) {
-    // zero array
-    for (int i = 0; i < npoints; i++) {
-        normals[i] = vec3(0, 0, 0);
-    }
-    //compute normal for each triangle, accululate for each vertex
-    int ntriangles = sizeof(triangles) / (3 * sizeof(int));
-    for (int i = 0; i < ntriangles; i++) {
-        int* t = triangles[i];
-        vec3 p1(points[t[0]]), p2(points[t[1]]), p3(points[t[2]]);
-        vec3 n = normalize(cross(p3 - p2, p2 - p1));
-        for (int k = 0; k < 3; k++)
-            normals[t[k]] += n;
-    }
-    for (int i = 0; i < npoints; i++)
-        normals[i] = normalize(normals[i]);
-
-    // init app window and GL context
-    glfwInit();
-    GLFWwindow *w = glfwCreateWindow(screenWidth, screenHeight, "Smooth Shading Face", NULL, NULL);
-    glfwSetWindowPos(w, 100, 100);
-    glfwMakeContextCurrent(w);
-    gladLoadGLLoader((GLADloadproc) glfwGetProcAddress);
-    // init shader and GPU data
-    progFaceted = LinkProgramViaCode(&vertexShader, &pixelShader);
-    InitVertexBuffer();
-    printf(usage);
-    // callbacks
-    glfwSetCursorPosCallback(w, MouseMove);
-    glfwSetMouseButtonCallback(w, MouseButton);
-    glfwSetScrollCallback(w, MouseWheel);
-    glfwSetWindowSizeCallback(w, Resize);
-    // event loop
-    glfwSwapInterval(1);
-    while (!glfwWindowShouldClose(w)) {
-        glfwPollEvents();
-        Display(w);
-        glfwSwapBuffers(w);
-    }
-    glDeleteBuffers(1, &vBuffer);
-    glfwDestroyWindow(w);
-    glfwTerminate();
-}
+// Original: FacetedGouraud.cpp (c) Jules Bloomenthal 2020, all rights reserved
+// Modified: SmoothShadingFace.cpp by Edward Lam
+
+#include <glad.h>
+#include <GLFW/glfw3.h>
+#include <stdio.h>
+#include <algorithm>
+#include <chrono>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include "Bvh.h"
+#include "Camera.h"
+#include "CameraBlock.h"
+#include "Draw.h"
+#include "GLXtras.h"
+#include "GpuTimer.h"
+#include "Headless.h"
+#include "Instances.h"
+#include "Mesh.h"
+#include "MeshLoader.h"
+#include "MeshOptimize.h"
+#include "Normals.h"
+#include "Redraw.h"
+#include "SoftRaster.h"
+#include "Uniforms.h"
+#include "VecBatch.h"
+#include "VecMat.h"
+#include "Widgets.h"
+#include <float.h>
+using namespace std;
+
+
+// vertex buffer and layout, triangle ids, shader program id
+Mesh mesh;
+IndexBuffer indices;
+GLuint progFaceted = 0;
+
+// display parameters
+int screenWidth = 900, screenHeight = 900;
+Camera camera(screenWidth, screenHeight, vec3(0, 0, 0), vec3(0, 0, -20), 30);
+    // respond to mouse events, half screen size, set back on z-axis, with fov of 30
+
+// interaction
+vec3 light(1.1f, 1.7f, -1.2f);
+Mover lightMover;
+void *picked = NULL;
+
+
+
+// Shaders
+
+const char* vertexShader = R"(
+    #version 140
+    in vec3 point;
+    in vec3 normal;
+    in vec3 color;
+    out vec3 vPoint;
+    out vec3  vNormal;
+    out vec3 vColor;
+    layout (std140, row_major) uniform Camera { mat4 modelview, persp, fullview; };
+    void main() {
+        vPoint = (modelview*vec4(point,1)).xyz;
+        vNormal = (modelview*vec4(normal,0)).xyz;
+        vColor = vec3(1,1,1);
+        gl_Position = persp*vec4(vPoint, 1);
+    }
+)";
+
+// crowd: as above, placed and tinted per instance (see Instances.h)
+const char* crowdVertexShader = R"(
+    #version 140
+    in vec3 point;
+    in vec3 normal;
+    in mat3x4 model;
+    in vec4 tint;
+    out vec3 vPoint;
+    out vec3  vNormal;
+    out vec3 vColor;
+    layout (std140, row_major) uniform Camera { mat4 modelview, persp, fullview; };
+    void main() {
+        vPoint = (modelview*vec4(vec4(point,1)*model, 1)).xyz;
+        vNormal = (modelview*vec4(vec4(normal,0)*model, 0)).xyz;
+        vColor = tint.rgb;
+        gl_Position = persp*vec4(vPoint, 1);
+    }
+)";
+
+const char* pixelShader = R"(
+    #version 130
+    uniform float a = .2;
+    in vec3 vPoint;
+    in vec3 vNormal;
+    in vec3 vColor;
+    out vec4 pColor;
+
+    uniform vec3 lightPos = vec3(1,0,0);
+
+    vec3 N = normalize(vNormal);
+
+    vec3 L = normalize(lightPos-vPoint);
+
+    float d = abs(dot(N,L));
+
+    vec3 R = reflect(L,N);
+
+    vec3 E = normalize(vPoint);
+
+    void main() {
+        float h = max(0, dot(R,E));
+        float s = pow(h, 100);
+        float intensity = clamp(a+d+s, 0, 1);
+        pColor = vec4(intensity*vColor, 1);
+    }
+)";
+
+
+
+// Mouse
+
+bool Shift(GLFWwindow *w) {
+    return glfwGetKey(w, GLFW_KEY_LEFT_SHIFT) == GLFW_PRESS ||
+           glfwGetKey(w, GLFW_KEY_RIGHT_SHIFT) == GLFW_PRESS;
+}
+
+int WindowHeight(GLFWwindow *w) {
+    int width, height;
+    glfwGetWindowSize(w, &width, &height);
+    return height;
+}
+
+void MouseButton(GLFWwindow *w, int butn, int action, int mods) {
+    double x, y;
+    glfwGetCursorPos(w, &x, &y);
+	y = WindowHeight(w)-y;
+    picked = NULL;
+    if (action == GLFW_PRESS) {
+        if (MouseOver(x, y, light, camera.fullview, 20)) {
+			picked = &lightMover;
+            lightMover.Down(&light, (int) x, (int) y, camera.modelview, camera.persp);
+        }
+        if (picked == NULL) {
+            picked = &camera;
+            camera.MouseDown((int) x, (int) y);
+        }
+    }
+    if (action == GLFW_RELEASE)
+        camera.MouseUp();
+    Redraw();
+}
+
+void MouseMove(GLFWwindow *w, double x, double y) {
+	y = WindowHeight(w)-y;
+    if (glfwGetMouseButton(w, GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS) {
+        if (picked == &lightMover)
+            lightMover.Drag((int) x, (int) y, camera.modelview, camera.persp);
+        else
+            camera.MouseDrag(x, y, Shift(w));
+        Redraw();
+    }
+}
+
+void MouseWheel(GLFWwindow *w, double ignore, double spin) {
+    camera.MouseWheel(spin > 0, Shift(w));
+    Redraw();
+}
+
+// Vertex Buffer
+
+struct Vertex {
+    vec3 point, color, normal;
+    Vertex() { }
+    Vertex(vec3 p, vec3 c, vec3 n) : point(p), color(c), normal(n) { }
+};
+
+int faceTriangles[][3] = { 
+    //triangles -- index starts from 0
+    {0,1,11},{1,11,12},{1,2,12},{2,12,13},{12,13,14},{13,14,16},{13,15,16},{2,3,13},{3,13,15},
+    {3,4,15},{4,15,17},{15,17,18},{15,18,19},{15,16,19},{14,16,24},{16,19,24},{18,19,23},{19,23,24},
+    {18,21,23},{20,21,22},{4,17,20},{4,20,22},{4,22,32},{4,32,5},{21,22,23},{23,24,28},{22,23,28},
+    {22,27,28},{32,26,22},{22,26,27},{5,32,25},{5,25,6},{6,25,26},{6,26,27},{6,27,7},{7,27,8},
+    {8,27,29},{27,29,30},{27,28,30},{30,28,31},{30,10,31},{9,30,10}
+};
+
+vec3 facePoints[] = {
+    vec3(0,.85f,.19f),vec3(0,.7f,.25f),vec3(0,.45f,.3f),vec3(0,.35f,.3f),                           //1-4
+    vec3(0,-.2f,.45f),vec3(0,-.1f,.52f),vec3(0,-.2f,.35f),vec3(0,-.3f,.4f),                         //5-8
+    vec3(0,-.4f,.4f), vec3(0, -.5f, .35f), vec3(0,-.85f, .22f), vec3(.4f,.8f,.05f),                 //9-12
+    vec3(.55f,.65f,-.1f),vec3(.51f,.5f,-.1f),vec3(.68f,.49f,-.2f),vec3(.35f,-.2f,.2f),              //13-16
+    vec3(.59f,.37f,-.1f),vec3(.24f,.26f,.28f),vec3(.49f,.21f,-.01f),vec3(.55f,.21f,-.01f),          //17-20
+    vec3(.18f,.2f,.3f),vec3(.36f,.15f,.2f),vec3(.3f,.5f,.2f),vec3(.48f,.01f,.08f),                  //21-24
+    vec3(.68f,-.01f,-.33f),vec3(.1f,-.1f,.25f),vec3(.18f,-.13f,-.25f),vec3(.2f,-.2f,.29f),          //25-28
+    vec3(.55f,-.35f,-.49f),vec3(.1f,-.41f,.29f),vec3(.28f,-.47f,.23f),vec3(.35f,-.78f,-.2f),        //29-32
+    vec3(.12f,-.01f,.33f),                                                                          //33 Missed in middle
+
+};
+
+// mesh in use: the face above, or one read from an OBJ/PLY file
+vector<vec3> points, normals;
+vector<int> triangles;
+VertexNormals vertexNormals;
+MeshCache cache;        // if a .bmesh was given: mapped points, normals, triangles
+int sizePts;
+
+void ComputeNormals() {
+    // adjacency once per topology, then parallel face normals and per-vertex gather
+    // (uniform weights match the original per-triangle loop)
+    normals.resize(points.size());
+    vertexNormals.Build(triangles.data(), triangles.size()/3, points.size());
+    vertexNormals.Compute(points.data(), normals.data(), WeightUniform);
+}
+
+void InitVertexBuffer() {
+    if (cache.nPoints) {
+        // points and normals go to the GPU straight from the mapped file
+        mesh.Allocate(cache.VertexBytes(), cache.VertexData());
+        mesh.Attribute(progFaceted, "point", 3, 0, 0);
+        mesh.Attribute(progFaceted, "normal", 3, 0, cache.NormalOffset());
+        indices.Allocate(cache.triangles, 3*cache.nTriangles, cache.nPoints);
+        mesh.Attach(indices);
+        return;
+    }
+    // create GPU buffer to hold positions and normals, allocate memory
+    sizePts = points.size()*sizeof(vec3);
+    int sizeNms = normals.size()*sizeof(vec3);
+    mesh.Allocate(sizePts + sizeNms);
+    // load data to sub-buffers
+    mesh.SubData(0, sizePts, &points[0]);
+    mesh.SubData(sizePts, sizeNms, &normals[0]);
+    // record vertex feed once, in the mesh's vertex array object
+    mesh.Attribute(progFaceted, "point", 3, 0, 0);
+    mesh.Attribute(progFaceted, "normal", 3, 0, sizePts);
+    // triangle ids to the GPU once, 16-bit if fewer than 64K points
+    indices.Allocate(triangles.data(), triangles.size(), points.size());
+    mesh.Attach(indices);
+}
+
+// Crowd
+
+InstanceBuffer crowd;       // if --crowd n: n copies of the mesh, drawn in one call
+int crowdCols = 1, nTurn = 0;
+float crowdSpacing = 1;
+bool cullCrowd = false;     // if --cull: draw only heads in view
+Bvh crowdBvh;               // world boxes of the heads
+Bounds headBounds;          // box of the mesh
+vector<int> visibleHeads;
+float cullMs = 0;           // total time culling, over cullFrames
+int cullFrames = 0;
+
+mat4 CrowdModel(int i, float yaw) {
+    // grid in x, y about the origin, each head .9 of the spacing across
+    int nRows = (crowd.Count()+crowdCols-1)/crowdCols;
+    float x = (i%crowdCols-.5f*(crowdCols-1))*crowdSpacing, y = (i/crowdCols-.5f*(nRows-1))*crowdSpacing;
+    return Translate(x, y, 0)*RotateY(yaw)*Scale(.45f*crowdSpacing);
+}
+
+float Random(float lo, float hi) {
+    return lo+(hi-lo)*rand()/RAND_MAX;
+}
+
+void InitCrowd(int n) {
+    crowdCols = (int) ceil(sqrt((float) n));
+    crowdSpacing = 6.f/crowdCols;
+    crowd.Resize(n);
+    vector<Bounds> boxes(n);
+    bool mapped = cache.nPoints > 0;
+    const vec3 *p = mapped? cache.points : points.data();
+    for (int i = 0, nPoints = mapped? cache.nPoints : (int) points.size(); i < nPoints; i++)
+        headBounds.Add(Bounds(p[i], p[i]));
+    for (int i = 0; i < n; i++) {
+        mat4 model = CrowdModel(i, Random(-40, 40));
+        crowd.Set(i, model, vec4(Random(.5f, 1), Random(.5f, 1), Random(.5f, 1), 1));
+        boxes[i] = Transform(model, headBounds);
+    }
+    crowd.Attributes(mesh, progFaceted);
+    if (cullCrowd)
+        crowdBvh.Build(boxes.data(), n);
+}
+
+void TurnHeads() {
+    // nTurn heads face a new way each frame: the upload is O(nTurn), however large the crowd
+    for (int k = 0; k < nTurn; k++) {
+        int i = rand()%crowd.Count();
+        mat4 model = CrowdModel(i, Random(-40, 40));
+        crowd.Set(i, model, crowd.Get(i).tint);
+        if (cullCrowd)
+            crowdBvh.Update(i, Transform(model, headBounds));
+    }
+}
+
+int CullCrowd() {
+    // ids of heads in view to visibleHeads, before any GL call; return their number
+    auto start = chrono::steady_clock::now();
+    crowdBvh.Cull(camera.fullview, visibleHeads);
+    cullMs += chrono::duration<float, milli>(chrono::steady_clock::now()-start).count();
+    cullFrames++;
+    return (int) visibleHeads.size();
+}
+
+void ReportCull(FILE *out) {
+    const Bvh::Stats &s = crowdBvh.stats;
+    fprintf(out, "cull (last frame): %i of %i heads visible, %i culled; %i nodes, %i heads tested; %.3f ms average\n",
+            s.visible, crowdBvh.Count(), s.culled, s.nodesTested, s.objectsTested, cullFrames? cullMs/cullFrames : 0);
+}
+
+// Display
+
+GpuTimer gpuTimer;      // GPU time of face and light (printed on exit)
+
+void Display(GLFWwindow *w) {
+
+    // clear screen, enable z-buffer
+    glClearColor(.5, .5, .5, 1);
+    glClear(GL_COLOR_BUFFER_BIT);
+    glClear(GL_DEPTH_BUFFER_BIT);
+    glEnable(GL_DEPTH_TEST);
+	glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    gpuTimer.Begin("face");
+    glUseProgram(progFaceted);
+    UpdateCameraBlock(camera);          // sends matrices only if the camera changed
+    SetUniform(UniformLocation(progFaceted, "lightPos"), light);
+    if (crowd.Count()) {
+        TurnHeads();
+        int n = crowd.Count();
+        if (cullCrowd) {
+            n = CullCrowd();
+            crowd.Upload(visibleHeads.data(), n);
+        }
+        else
+            crowd.Upload();
+        mesh.Bind();
+        indices.DrawInstanced(GL_TRIANGLES, n);
+    }
+    else {
+        mesh.Bind();
+        indices.Draw(GL_TRIANGLES);
+    }
+    mesh.Unbind();
+    gpuTimer.End();
+    // draw light
+    gpuTimer.Begin("light");
+    UseDrawShader(camera.fullview);
+    glDisable(GL_DEPTH_TEST);
+    bool visible = IsVisible(light, camera.fullview);
+    bool incube = fabs(light.x) < 1 && fabs(light.y) < 1 && fabs(light.z) < 1;
+    Disk(light, 12, incube? vec3(0,0,1) : vec3(1,0,0), visible? 1 : .25f);
+    gpuTimer.End();
+    gpuTimer.EndFrame();
+    glFlush();
+}
+
+// Application
+
+const char *usage = "Usage\n\
+    mouse-drag:\t\trotate x,y\n\
+    with shift:\t\ttranslate x,y\n\
+    mouse-wheel:\trotate/translate z\n";
+
+void Resize(GLFWwindow *w, int width, int height) {
+    camera.Resize(width, height);
+    glViewport(0, 0, screenWidth = width, screenHeight = height);
+    Redraw();
+}
+
+void Normalize() {
+    int npoints = points.size();
+    // scale and offset so that points all within +/-1 in x, y , and z
+    vec3 mn(FLT_MAX), mx(-FLT_MAX);
+    for (int i = 0; i < npoints; i++) {
+        vec3 p = points[i];
+        for (int k = 0; k < 3; k++) {
+            if (p[k] < mn[k]) mn[k] = p[k];
+            if (p[k] > mx[k]) mx[k] = p[k];
+        }
+    }
+    vec3 center = .5f * (mn + mx), range = mx - mn;
+    float maxrange = max(range.x, max(range.y, range.z));
+    float s = 2 / maxrange;
+    for (int i = 0; i < npoints; i++)
+        points[i] = s * (points[i] - center);
+}
+
+// Software Rendering
+
+int RenderSoft(const char *filename, int ac, char **av) {
+    // the shaders above, on the CPU (without the light's disk); options as RenderSoftFrames()
+    bool mapped = cache.nPoints > 0;
+    const vec3 *p = mapped? cache.points : points.data(), *n = mapped? cache.normals : normals.data();
+    const int *t = mapped? cache.triangles : triangles.data();
+    int nPoints = mapped? cache.nPoints : (int) points.size();
+    int nTriangles = mapped? cache.nTriangles : (int) triangles.size()/3;
+    mat4 modelview, persp;
+    // vertex shader: varyings vPoint (0-2) and vNormal (3-5)
+    auto vertex = [&](int i, float *v) {
+        vec4 q = modelview*vec4(p[i], 1), m = modelview*vec4(n[i], 0);
+        v[0] = q.x; v[1] = q.y; v[2] = q.z;
+        v[3] = m.x; v[4] = m.y; v[5] = m.z;
+        return persp*vec4(q.x, q.y, q.z, 1);
+    };
+    // pixel shader
+    auto pixel = [&](const float *v) {
+        vec3 vPoint(v[0], v[1], v[2]), N = normalize(vec3(v[3], v[4], v[5]));
+        vec3 L = normalize(light-vPoint), R = L-2*dot(N, L)*N, E = normalize(vPoint);
+        float d = fabs(dot(N, L)), s = pow(max(0.f, dot(R, E)), 100.f);
+        float intensity = min(1.f, .2f+d+s);
+        return vec3(intensity, intensity, intensity);
+    };
+    return RenderSoftFrames(filename, ac, av, [&](SoftRaster &raster) {
+        camera.Resize(raster.Width(), raster.Height());
+        modelview = camera.modelview;
+        persp = camera.persp;
+        raster.Draw(nPoints, t, nTriangles, 6, vertex, pixel);
+    });
+}
+
+
+int main(int ac, char **av) {
+    // mesh from command-line .bmesh (mapped as is), or .obj/.ply, else the built-in face
+    const char *meshFile = MeshFileArg(ac, av);
+    string name(meshFile? meshFile : "face.obj");
+    if (name.size() > 6 && name.substr(name.size()-6) == ".bmesh") {
+        auto start = chrono::steady_clock::now();
+        if (!cache.Open(meshFile))
+            return 1;
+        printf("%s: %i points, %i triangles, mapped in %.1f ms\n", meshFile, cache.nPoints,
+               cache.nTriangles, chrono::duration<float, milli>(chrono::steady_clock::now()-start).count());
+    }
+    else {
+        if (meshFile) {
+            auto start = chrono::steady_clock::now();
+            if (!ReadMesh(meshFile, points, triangles))
+                return 1;
+            printf("%s: %i points, %i triangles, read in %.1f ms\n", meshFile, (int) points.size(),
+                   (int) triangles.size()/3, chrono::duration<float, milli>(chrono::steady_clock::now()-start).count());
+            Normalize();
+        }
+        else {
+            points.assign(facePoints, facePoints+sizeof(facePoints)/sizeof(vec3));
+            triangles.assign(&faceTriangles[0][0], &faceTriangles[0][0]+sizeof(faceTriangles)/sizeof(int));
+        }
+        // optional: --crease degrees splits vertices at sharp edges, --normals times normal computation,
+        // --vecbatch times the SIMD batch kernels, --bvh times frustum culling, --cache saves the processed mesh beside the input
+        // as .bmesh for fast startup
+        bool writeCache = false;
+        for (int i = 1; i < ac; i++) {
+            if (!strcmp(av[i], "--crease") && i+1 < ac)
+                printf("crease split added %i points\n", SplitCreases(points, triangles, (float) atof(av[++i])));
+            if (!strcmp(av[i], "--normals")) {
+                BenchmarkNormals(points, triangles);
+                return 0;
+            }
+            if (!strcmp(av[i], "--vecbatch")) {
+                BenchmarkVecBatch();
+                return 0;
+            }
+            if (!strcmp(av[i], "--bvh")) {
+                BenchmarkBvh();
+                return 0;
+            }
+            writeCache = writeCache || !strcmp(av[i], "--cache");
+        }
+        // reorder for post-transform cache, overdraw and vertex fetch before normals and upload
+        // (fronts are clockwise: ComputeNormals' face normals are cross(p3-p2, p2-p1))
+        float acmr = ACMR(triangles.data(), triangles.size()/3);
+        OptimizeMesh(points, triangles, true, false);
+        if (meshFile)
+            printf("ACMR %.3f -> %.3f\n", acmr, ACMR(triangles.data(), triangles.size()/3));
+        ComputeNormals();
+        if (writeCache) {
+            name = name.substr(0, name.rfind('.'))+".bmesh";
+            if (WriteMeshCache(name.c_str(), points, normals, triangles))
+                printf("wrote %s\n", name.c_str());
+        }
+    }
+
+    // or render on the CPU, without GL: --soft file.ppm [--size WxH] [--frames n] [--threads n]
+    for (int i = 1; i < ac; i++)
+        if (!strcmp(av[i], "--soft") && i+1 < ac)
+            return RenderSoft(av[i+1], ac, av);
+
+    // init app window and GL context (offscreen if benchmarking)
+    bool bench = HeadlessArgs(ac, av);
+    GLFWwindow *w = NULL;
+    if (bench) {
+        if (!InitHeadless(screenWidth, screenHeight))
+            return 1;
+    }
+    else {
+        glfwInit();
+        w = glfwCreateWindow(screenWidth, screenHeight, "Smooth Shading Face", NULL, NULL);
+        glfwSetWindowPos(w, 100, 100);
+        glfwMakeContextCurrent(w);
+        gladLoadGLLoader((GLADloadproc) glfwGetProcAddress);
+    }
+    // init shader and GPU data; --crowd n [--turn k] [--cull]: n instances, k re-posed
+    // each frame, those out of view culled
+    int nCrowd = 0;
+    for (int i = 1; i < ac; i++) {
+        if (!strcmp(av[i], "--crowd") && i+1 < ac)
+            nCrowd = atoi(av[++i]);
+        else if (!strcmp(av[i], "--turn") && i+1 < ac)
+            nTurn = atoi(av[++i]);
+        else
+            cullCrowd = cullCrowd || !strcmp(av[i], "--cull");
+    }
+    progFaceted = LinkProgramViaCode(nCrowd > 0? &crowdVertexShader : &vertexShader, &pixelShader);
+    CacheLocations(progFaceted);
+    BindCameraBlock(progFaceted);
+    InitVertexBuffer();
+    if (nCrowd > 0) {
+        InitCrowd(nCrowd);
+        RedrawContinuously(nTurn > 0);
+    }
+    if (bench) {
+        // report GPU times while the context is current (stdout holds the benchmark JSON)
+        int r = RunHeadless("SmoothShadingFace", [] { Display(NULL); }, &camera, [] { gpuTimer.Report(stderr); });
+        if (cullCrowd)
+            ReportCull(stderr);
+        return r;
+    }
+    printf(usage);
+    // callbacks
+    glfwSetCursorPosCallback(w, MouseMove);
+    glfwSetMouseButtonCallback(w, MouseButton);
+    glfwSetScrollCallback(w, MouseWheel);
+    glfwSetWindowSizeCallback(w, Resize);
+    // event loop: draw only after input or resize
+    glfwSwapInterval(1);
+    while (NextFrame(w)) {
+        Display(w);
+        glfwSwapBuffers(w);
+    }
+    mesh.Release();
+    indices.Release();
+    crowd.Release();
+    ReleaseCameraBlock();
+    cache.Close();
+    gpuTimer.Report();
+    if (cullCrowd)
+        ReportCull(stdout);
+    gpuTimer.Release();
+    glfwDestroyWindow(w);
+    glfwTerminate();
+}
@@ -1,163 +1,210 @@
-// BezierCurve.cpp - interactive curve design
-// Exercse 16.8 et Maintenant, Bezier by Edward Lam
-
-#include <glad.h>
-#include <GLFW/glfw3.h>
-#include <stdio.h>
-#include "Camera.h"
-#include "Draw.h"           // for Line()
-#include "GLXtras.h"
-#include "Widgets.h"
-#include "sphere.h"
-
-int     winW = 900, winH = 800;
-Camera  camera(winW, winH, vec3(0,0,0), vec3(0,0,-5));
-Mover   ptMover;
-
-// Bezier curve
-
-class Bezier {
-public:
-    vec3 p1, p2, p3, p4;    // control points
-    int res;                // display resolution
-    Bezier(const vec3 &p1, const vec3 &p2, const vec3 &p3, const vec3 &p4, int res = 50) :
-        p1(p1), p2(p2), p3(p3), p4(p4), res(res) { }
-    vec3 Point(float t) {
-        float t_sqrd = (t * t);
-        float t_cubed = (t * t * t);
-        vec3 first_t = p1 * (-t_cubed + (3 * t_sqrd) - (3 * t) + 1);
-        vec3 second_t = p2 * ((3 * t_cubed) - (6 * t_sqrd) + (3 * t));
-        vec3 third_t = p3 * ((-3 * t_cubed) + (3 * t_sqrd));
-        vec3 fourth_t = p4 * (t_cubed);
-        return first_t + second_t + third_t + fourth_t;	// point on curve at t
-    }
-    void Draw(vec3 color, float width) {
-        // break the curve into res number of straight pieces
-        // *** render each piece with Line() ***
-        vec3 pts[] = { p1, p1 };
-        for (int i = 1; i <= res; i++) {
-            pts[1] = Point((float)i / res);
-            Line(pts[0], pts[1], width, color);
-            pts[0] = pts[1];
-        }
-    }
-    void DrawControlMesh(vec3 pointColor, vec3 meshColor, float opacity, float width) {
-        Line(p1, p2, 4.0f, meshColor, width, opacity);
-        Line(p2, p3, 4.0f, meshColor, width, opacity);
-        Line(p3, p4, 4.0f, meshColor, width, opacity);
-    }
-    vec3 *PickPoint(int x, int y, mat4 view) {
-        // return pointer to nearest control point, if within 10 pixels of mouse (x,y), else NULL
-        // hint: use ScreenDistSq
-        float p1_Distance = ScreenDistSq(x, y, p1, view);
-        float p2_Distance = ScreenDistSq(x, y, p2, view);
-        float p3_Distance = ScreenDistSq(x, y, p3, view);
-        float p4_Distance = ScreenDistSq(x, y, p4, view);
-
-        if (p1_Distance < 10)
-            return &p1;
-        else if (p2_Distance < 10)
-            return &p2;
-        else if (p3_Distance < 10)
-            return &p3;
-        else if (p4_Distance < 10)
-            return &p4;
-        else
-            return NULL;
-    }
-};
-
-Bezier  curve(vec3(.1, .3, 0), vec3(.3, .4, .2), vec3(-.2, .3, .2), vec3(-.3, .1, .2)) ;//vec3(???), vec3(???), vec3(???), vec3(???));
-
-// Display
-
-void Display() {
-    // background, blending, zbuffer
-    glClearColor(.6f, .6f, .6f, 1);
-    glClear(GL_COLOR_BUFFER_BIT);
-    glEnable(GL_BLEND);
-    glEnable(GL_LINE_SMOOTH);
-    glHint(GL_LINE_SMOOTH_HINT, GL_NICEST);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-    glDisable(GL_DEPTH_TEST);
-    // draw curve and control polygon
-    UseDrawShader(camera.fullview); // no shading, so single matrix
-    curve.Draw(vec3(.7f, .2f, .5f), 3.5f);
-    curve.DrawControlMesh(vec3(0, .4f, 0), vec3(1, 1, 0), 1, 2.5f);
-    glFlush();
-}
-
-// Mouse
-
-int WindowHeight(GLFWwindow *w) {
-    int width, height;
-    glfwGetWindowSize(w, &width, &height);
-    return height;
-}
-
-bool Shift(GLFWwindow *w) {
-    return glfwGetKey(w, GLFW_KEY_LEFT_SHIFT) == GLFW_PRESS ||
-           glfwGetKey(w, GLFW_KEY_RIGHT_SHIFT) == GLFW_PRESS;
-}
-
-void MouseButton(GLFWwindow *w, int butn, int action, int mods) {
-    double x, y;
-    glfwGetCursorPos(w, &x, &y);
-    y = WindowHeight(w)-y;              // invert y for upward-increasing screen space
-    if (action == GLFW_RELEASE) {
-        camera.MouseUp();               // reset rotation accumulation
-        ptMover.Unset();                // deselect control point
-    }
-    if (action == GLFW_PRESS) {
-        vec3 *pp = curve.PickPoint(x, y, camera.fullview);
-        if (pp) {
-            if (glfwGetMouseButton(w, GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS)
-                ptMover.Down(pp, x, y, camera.modelview, camera.persp);
-        }
-        else
-            camera.MouseDown(x, y);
-    }
-}
-
-void MouseMove(GLFWwindow *w, double x, double y) {
-    y = WindowHeight(w)-y;
-    if (glfwGetMouseButton(w, GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS) { // drag
-        if (ptMover.IsSet())
-            ptMover.Drag((int) x, (int) y, camera.modelview, camera.persp);
-        else
-            camera.MouseDrag((int) x, (int) y, Shift(w));
-    }
-}
-
-void MouseWheel(GLFWwindow *w, double xoffset, double yoffset) {
-    camera.MouseWheel(yoffset, Shift(w));
-}
-
-// Application
-
-void Resize(GLFWwindow *w, int width, int height) {
-    glViewport(0, 0, winW = width, winH = height);
-    camera.Resize(width, height);
-}
-
-int main(int ac, char **av) {
-    // init app window and GL context
-    glfwInit();
-    GLFWwindow *w = glfwCreateWindow(winW, winH, "Bezier Curve by Edward Lam", NULL, NULL);
-    glfwSetWindowPos(w, 100, 100);
-    glfwMakeContextCurrent(w);
-    gladLoadGLLoader((GLADloadproc) glfwGetProcAddress);
-    // callbacks
-    glfwSetCursorPosCallback(w, MouseMove);
-    glfwSetMouseButtonCallback(w, MouseButton);
-    glfwSetScrollCallback(w, MouseWheel);
-    glfwSetWindowSizeCallback(w, Resize);
-   // event loop
-    while (!glfwWindowShouldClose(w)) {
-        Display();
-        glfwPollEvents();
-        glfwSwapBuffers(w);
-    }
-    glfwDestroyWindow(w);
-    glfwTerminate();
-}
+// BezierCurve.cpp - interactive curve design
+// Exercse 16.8 et Maintenant, Bezier by Edward Lam
+
+#include <glad.h>
+#include <GLFW/glfw3.h>
+#include <stdio.h>
+#include "Camera.h"
+#include "CameraBlock.h"
+#include "GLXtras.h"
+#include "Headless.h"
+#include "Overlay.h"
+#include "Picker.h"
+#include "Redraw.h"
+#include "Widgets.h"
+#include "sphere.h"
+
+int     winW = 900, winH = 800;
+Camera  camera(winW, winH, vec3(0,0,0), vec3(0,0,-5));
+Mover   ptMover;
+Overlay overlay;        // curves and control polygons, drawn in one call
+
+// Bezier curve
+
+class Bezier {
+public:
+    vec3 p1, p2, p3, p4;    // control points
+    float tolerance;        // display accuracy: max pixels between curve and its line segments
+    static const int maxDepth = 10;                 // subdivision limit: at most 2^maxDepth segments
+    static const int maxPoints = (1 << maxDepth)+1;
+    Bezier(const vec3 &p1, const vec3 &p2, const vec3 &p3, const vec3 &p4, float tolerance = .25f) :
+        p1(p1), p2(p2), p3(p3), p4(p4), tolerance(tolerance) { }
+    vec3 Point(float t) {
+        float t_sqrd = (t * t);
+        float t_cubed = (t * t * t);
+        vec3 first_t = p1 * (-t_cubed + (3 * t_sqrd) - (3 * t) + 1);
+        vec3 second_t = p2 * ((3 * t_cubed) - (6 * t_sqrd) + (3 * t));
+        vec3 third_t = p3 * ((-3 * t_cubed) + (3 * t_sqrd));
+        vec3 fourth_t = p4 * (t_cubed);
+        return first_t + second_t + third_t + fourth_t;	// point on curve at t
+    }
+    bool Flat(const vec3 b[4], const mat4 &view, vec2 viewport) {
+        // a cubic strays at most 3/4 max(|b0-2b1+b2|, |b1-2b2+b3|) from its chord;
+        // test that bound in pixels of viewport (false if any point is behind the eye)
+        vec2 s[4];
+        for (int i = 0; i < 4; i++) {
+            vec4 c = view*vec4(b[i], 1);
+            if (c.w <= 0)
+                return false;
+            s[i] = vec2(.5f*viewport.x*c.x/c.w, .5f*viewport.y*c.y/c.w);
+        }
+        float d2 = 0;
+        for (int i = 0; i < 2; i++) {
+            float dx = s[i].x-2*s[i+1].x+s[i+2].x, dy = s[i].y-2*s[i+1].y+s[i+2].y;
+            d2 = dx*dx+dy*dy > d2? dx*dx+dy*dy : d2;
+        }
+        return .5625f*d2 <= tolerance*tolerance;
+    }
+    int Flatten(const mat4 &view, vec2 viewport, vec3 *pts) {
+        // adaptive de Casteljau subdivision: split spans at their midpoint until each is
+        // within tolerance pixels of its chord, so flat spans get one segment and tight
+        // bends many; spans wait on a fixed stack (left halves first, so points emerge
+        // in order) and pts must hold maxPoints: nothing is allocated; return count
+        struct Span { vec3 b[4]; int depth; } stack[maxDepth+1];
+        int n = 0, top = 0;
+        pts[n++] = p1;
+        stack[top++] = { {p1, p2, p3, p4}, 0 };
+        while (top) {
+            Span s = stack[--top];
+            if (s.depth == maxDepth || Flat(s.b, view, viewport)) {
+                pts[n++] = s.b[3];
+                continue;
+            }
+            vec3 *b = s.b, b01 = .5f*(b[0]+b[1]), b12 = .5f*(b[1]+b[2]), b23 = .5f*(b[2]+b[3]);
+            vec3 b012 = .5f*(b01+b12), b123 = .5f*(b12+b23), m = .5f*(b012+b123);
+            stack[top++] = { {m, b123, b23, b[3]}, s.depth+1 };
+            stack[top++] = { {b[0], b01, b012, m}, s.depth+1 };
+        }
+        return n;
+    }
+    void Draw(vec3 color, float width) {
+        // break the curve into as few straight pieces as tolerance allows, for the overlay
+        static vec3 pts[maxPoints];     // shared by all curves, reused each frame
+        GLint vp[4];
+        glGetIntegerv(GL_VIEWPORT, vp);
+        int n = Flatten(camera.fullview, vec2((float) vp[2], (float) vp[3]), pts);
+        for (int i = 1; i < n; i++)
+            overlay.Line(pts[i-1], pts[i], width, color);
+    }
+    void DrawControlMesh(vec3 pointColor, vec3 meshColor, float opacity, float width) {
+        overlay.Line(p1, p2, width, meshColor, opacity);
+        overlay.Line(p2, p3, width, meshColor, opacity);
+        overlay.Line(p3, p4, width, meshColor, opacity);
+        vec3 pts[] = { p1, p2, p3, p4 };
+        for (int i = 0; i < 4; i++)
+            overlay.Disk(pts[i], 7, pointColor, opacity);
+    }
+    void AddHandles(PointPicker &picker) {
+        // register control points for picking
+        picker.Add(&p1);
+        picker.Add(&p2);
+        picker.Add(&p3);
+        picker.Add(&p4);
+    }
+};
+
+Bezier  curve(vec3(.1, .3, 0), vec3(.3, .4, .2), vec3(-.2, .3, .2), vec3(-.3, .1, .2)) ;//vec3(???), vec3(???), vec3(???), vec3(???));
+PointPicker picker;     // nearest control point of any curve within 10 pixels of the mouse
+
+// Display
+
+void Display() {
+    // background, blending, zbuffer
+    glClearColor(.6f, .6f, .6f, 1);
+    glClear(GL_COLOR_BUFFER_BIT);
+    glEnable(GL_BLEND);
+    glEnable(GL_LINE_SMOOTH);
+    glHint(GL_LINE_SMOOTH_HINT, GL_NICEST);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glDisable(GL_DEPTH_TEST);
+    // draw curve and control polygon
+    curve.Draw(vec3(.7f, .2f, .5f), 3.5f);
+    curve.DrawControlMesh(vec3(0, .4f, 0), vec3(1, 1, 0), 1, 2.5f);
+    UpdateCameraBlock(camera);
+    overlay.Flush(); // curve and control mesh in one draw
+    glFlush();
+}
+
+// Mouse
+
+int WindowHeight(GLFWwindow *w) {
+    int width, height;
+    glfwGetWindowSize(w, &width, &height);
+    return height;
+}
+
+bool Shift(GLFWwindow *w) {
+    return glfwGetKey(w, GLFW_KEY_LEFT_SHIFT) == GLFW_PRESS ||
+           glfwGetKey(w, GLFW_KEY_RIGHT_SHIFT) == GLFW_PRESS;
+}
+
+void MouseButton(GLFWwindow *w, int butn, int action, int mods) {
+    double x, y;
+    glfwGetCursorPos(w, &x, &y);
+    y = WindowHeight(w)-y;              // invert y for upward-increasing screen space
+    if (action == GLFW_RELEASE) {
+        camera.MouseUp();               // reset rotation accumulation
+        ptMover.Unset();                // deselect control point
+    }
+    if (action == GLFW_PRESS) {
+        vec3 *pp = picker.Pick((int) x, (int) y, camera.fullview);
+        if (pp) {
+            if (glfwGetMouseButton(w, GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS)
+                ptMover.Down(pp, x, y, camera.modelview, camera.persp);
+        }
+        else
+            camera.MouseDown(x, y);
+    }
+}
+
+void MouseMove(GLFWwindow *w, double x, double y) {
+    y = WindowHeight(w)-y;
+    if (glfwGetMouseButton(w, GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS) { // drag
+        if (ptMover.IsSet()) {
+            ptMover.Drag((int) x, (int) y, camera.modelview, camera.persp);
+            picker.Moved();
+        }
+        else
+            camera.MouseDrag((int) x, (int) y, Shift(w));
+        Redraw();
+    }
+}
+
+void MouseWheel(GLFWwindow *w, double xoffset, double yoffset) {
+    camera.MouseWheel(yoffset, Shift(w));
+    Redraw();
+}
+
+// Application
+
+void Resize(GLFWwindow *w, int width, int height) {
+    glViewport(0, 0, winW = width, winH = height);
+    camera.Resize(width, height);
+    Redraw();
+}
+
+int main(int ac, char **av) {
+    curve.AddHandles(picker);
+    picker.radius = 10;
+    // init app window and GL context (offscreen if benchmarking)
+    if (HeadlessArgs(ac, av))
+        return InitHeadless(winW, winH)? RunHeadless("BezierCurve", Display, &camera) : 1;
+    glfwInit();
+    GLFWwindow *w = glfwCreateWindow(winW, winH, "Bezier Curve by Edward Lam", NULL, NULL);
+    glfwSetWindowPos(w, 100, 100);
+    glfwMakeContextCurrent(w);
+    gladLoadGLLoader((GLADloadproc) glfwGetProcAddress);
+    // callbacks
+    glfwSetCursorPosCallback(w, MouseMove);
+    glfwSetMouseButtonCallback(w, MouseButton);
+    glfwSetScrollCallback(w, MouseWheel);
+    glfwSetWindowSizeCallback(w, Resize);
+    // event loop: draw only after input or resize
+    while (NextFrame(w)) {
+        Display();
+        glfwSwapBuffers(w);
+    }
+    overlay.Release();
+    glfwDestroyWindow(w);
+    glfwTerminate();
+}
@@ -1,77 +1,450 @@
-// Teapot.cpp - Martin Newell's famed Utah teapot
-
-// Bezier control points
-vec3 controlPoints[] = {
-    vec3( 0.2000,  0.0000, 2.70000), vec3( 0.2000, -0.1120, 2.70000),
-    vec3( 0.1120, -0.2000, 2.70000), vec3( 0.0000, -0.2000, 2.70000),
-    vec3( 1.3375,  0.0000, 2.53125), vec3( 1.3375, -0.7490, 2.53125),
-    vec3( 0.7490, -1.3375, 2.53125), vec3( 0.0000, -1.3375, 2.53125),
-    vec3( 1.4375,  0.0000, 2.53125), vec3( 1.4375, -0.8050, 2.53125),
-    vec3( 0.8050, -1.4375, 2.53125), vec3( 0.0000, -1.4375, 2.53125),
-    vec3( 1.5000,  0.0000, 2.40000), vec3( 1.5000, -0.8400, 2.40000),
-    vec3( 0.8400, -1.5000, 2.40000), vec3( 0.0000, -1.5000, 2.40000),
-    vec3( 1.7500,  0.0000, 1.87500), vec3( 1.7500, -0.9800, 1.87500),
-    vec3( 0.9800, -1.7500, 1.87500), vec3( 0.0000, -1.7500, 1.87500),
-    vec3( 2.0000,  0.0000, 1.35000), vec3( 2.0000, -1.1200, 1.35000),
-    vec3( 1.1200, -2.0000, 1.35000), vec3( 0.0000, -2.0000, 1.35000),
-    vec3( 2.0000,  0.0000, 0.90000), vec3( 2.0000, -1.1200, 0.90000),
-    vec3( 1.1200, -2.0000, 0.90000), vec3( 0.0000, -2.0000, 0.90000),
-    vec3(-2.0000,  0.0000, 0.90000), vec3( 2.0000,  0.0000, 0.45000),
-    vec3( 2.0000, -1.1200, 0.45000), vec3( 1.1200, -2.0000, 0.45000),
-    vec3( 0.0000, -2.0000, 0.45000), vec3( 1.5000,  0.0000, 0.22500),
-    vec3( 1.5000, -0.8400, 0.22500), vec3( 0.8400, -1.5000, 0.22500),
-    vec3( 0.0000, -1.5000, 0.22500), vec3( 1.5000,  0.0000, 0.15000),
-    vec3( 1.5000, -0.8400, 0.15000), vec3( 0.8400, -1.5000, 0.15000),
-    vec3( 0.0000, -1.5000, 0.15000), vec3(-1.6000,  0.0000, 2.02500),
-    vec3(-1.6000, -0.3000, 2.02500), vec3(-1.5000, -0.3000, 2.25000),
-    vec3(-1.5000,  0.0000, 2.25000), vec3(-2.3000,  0.0000, 2.02500),
-    vec3(-2.3000, -0.3000, 2.02500), vec3(-2.5000, -0.3000, 2.25000),
-    vec3(-2.5000,  0.0000, 2.25000), vec3(-2.7000,  0.0000, 2.02500),
-    vec3(-2.7000, -0.3000, 2.02500), vec3(-3.0000, -0.3000, 2.25000),
-    vec3(-3.0000,  0.0000, 2.25000), vec3(-2.7000,  0.0000, 1.80000),
-    vec3(-2.7000, -0.3000, 1.80000), vec3(-3.0000, -0.3000, 1.80000),
-    vec3(-3.0000,  0.0000, 1.80000), vec3(-2.7000,  0.0000, 1.57500),
-    vec3(-2.7000, -0.3000, 1.57500), vec3(-3.0000, -0.3000, 1.35000),
-    vec3(-3.0000,  0.0000, 1.35000), vec3(-2.5000,  0.0000, 1.12500),
-    vec3(-2.5000, -0.3000, 1.12500), vec3(-2.6500, -0.3000, 0.93750),
-    vec3(-2.6500,  0.0000, 0.93750), vec3(-2.0000, -0.3000, 0.90000),
-    vec3(-1.9000, -0.3000, 0.60000), vec3(-1.9000,  0.0000, 0.60000),
-    vec3( 1.7000,  0.0000, 1.42500), vec3( 1.7000, -0.6600, 1.42500),
-    vec3( 1.7000, -0.6600, 0.60000), vec3( 1.7000,  0.0000, 0.60000),
-    vec3( 2.6000,  0.0000, 1.42500), vec3( 2.6000, -0.6600, 1.42500),
-    vec3( 3.1000, -0.6600, 0.82500), vec3( 3.1000,  0.0000, 0.82500),
-    vec3( 2.3000,  0.0000, 2.10000), vec3( 2.3000, -0.2500, 2.10000),
-    vec3( 2.4000, -0.2500, 2.02500), vec3( 2.4000,  0.0000, 2.02500),
-    vec3( 2.7000,  0.0000, 2.40000), vec3( 2.7000, -0.2500, 2.40000),
-    vec3( 3.3000, -0.2500, 2.40000), vec3( 3.3000,  0.0000, 2.40000),
-    vec3( 2.8000,  0.0000, 2.47500), vec3( 2.8000, -0.2500, 2.47500),
-    vec3( 3.5250, -0.2500, 2.49375), vec3( 3.5250,  0.0000, 2.49375),
-    vec3( 2.9000,  0.0000, 2.47500), vec3( 2.9000, -0.1500, 2.47500),
-    vec3( 3.4500, -0.1500, 2.51250), vec3( 3.4500,  0.0000, 2.51250),
-    vec3( 2.8000,  0.0000, 2.40000), vec3( 2.8000, -0.1500, 2.40000),
-    vec3( 3.2000, -0.1500, 2.40000), vec3( 3.2000,  0.0000, 2.40000),
-    vec3( 0.0000,  0.0000, 3.15000), vec3( 0.8000,  0.0000, 3.15000),
-    vec3( 0.8000, -0.4500, 3.15000), vec3( 0.4500, -0.8000, 3.15000),
-    vec3( 0.0000, -0.8000, 3.15000), vec3( 0.0000,  0.0000, 2.85000),
-    vec3( 1.4000,  0.0000, 2.40000), vec3( 1.4000, -0.7840, 2.40000),
-    vec3( 0.7840, -1.4000, 2.40000), vec3( 0.0000, -1.4000, 2.40000),
-    vec3( 0.4000,  0.0000, 2.55000), vec3( 0.4000, -0.2240, 2.55000),
-    vec3( 0.2240, -0.4000, 2.55000), vec3( 0.0000, -0.4000, 2.55000),
-    vec3( 1.3000,  0.0000, 2.55000), vec3( 1.3000, -0.7280, 2.55000),
-    vec3( 0.7280, -1.3000, 2.55000), vec3( 0.0000, -1.3000, 2.55000),
-    vec3( 1.3000,  0.0000, 2.40000), vec3( 1.3000, -0.7280, 2.40000),
-    vec3( 0.7280, -1.3000, 2.40000), vec3( 0.0000, -1.3000, 2.40000)
-};
-
-// Bezier patches
-int patches[][16] = {
-    {102, 103, 104, 105,   4,   5,   6,   7,   8,   9,  10,  11,  12,  13,  14,  15},   // rim (reflect x&y)
-    { 12,  13,  14,  15,  16,  17,  18,  19,  20,  21,  22,  23,  24,  25,  26,  27},   // body (reflect x&y)
-    { 24,  25,  26,  27,  29,  30,  31,  32,  33,  34,  35,  36,  37,  38,  39,  40},   // body (reflect x&y)
-    { 96,  96,  96,  96,  97,  98,  99, 100, 101, 101, 101, 101,   0,   1,   2,   3},   // lid (reflect x&y)
-    {  0,   1,   2,   3, 106, 107, 108, 109, 110, 111, 112, 113, 114, 115, 116, 117},   // lid (reflect x&y)
-    { 41,  42,  43,  44,  45,  46,  47,  48,  49,  50,  51,  52,  53,  54,  55,  56},   // handle (reflect y)
-    { 53,  54,  55,  56,  57,  58,  59,  60,  61,  62,  63,  64,  28,  65,  66,  67},   // handle (reflect y)
-    { 68,  69,  70,  71,  72,  73,  74,  75,  76,  77,  78,  79,  80,  81,  82,  83},   // spout (reflect y)
-    { 80,  81,  82,  83,  84,  85,  86,  87,  88,  89,  90,  91,  92,  93,  94,  95}    // spout (reflect y)
-};
+// Teapot.cpp - Martin Newell's famed Utah teapot
+// the 32-patch teapot is stored as 9 patches: the remaining 23 are reflections in x and/or y;
+// patches are tessellated on the CPU in parallel (one job per patch) and the reflected
+// copies are drawn by instancing, with a per-instance mirror matrix, rather than stored;
+// dragging a control point flags the patches that share it, and only those are
+// re-tessellated and re-uploaded, on the next frame
+
+#include <glad.h>
+#include <GLFW/glfw3.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <vector>
+#include "Camera.h"
+#include "CameraBlock.h"
+#include "GLXtras.h"
+#include "Headless.h"
+#include "Mesh.h"
+#include "Overlay.h"
+#include "Parallel.h"
+#include "Picker.h"
+#include "ProgramCache.h"
+#include "Redraw.h"
+#include "Tessellate.h"
+#include "Uniforms.h"
+#include "VecMat.h"
+#include "Widgets.h"
+
+
+// Bezier control points
+vec3 controlPoints[] = {
+    vec3( 0.2000,  0.0000, 2.70000), vec3( 0.2000, -0.1120, 2.70000),
+    vec3( 0.1120, -0.2000, 2.70000), vec3( 0.0000, -0.2000, 2.70000),
+    vec3( 1.3375,  0.0000, 2.53125), vec3( 1.3375, -0.7490, 2.53125),
+    vec3( 0.7490, -1.3375, 2.53125), vec3( 0.0000, -1.3375, 2.53125),
+    vec3( 1.4375,  0.0000, 2.53125), vec3( 1.4375, -0.8050, 2.53125),
+    vec3( 0.8050, -1.4375, 2.53125), vec3( 0.0000, -1.4375, 2.53125),
+    vec3( 1.5000,  0.0000, 2.40000), vec3( 1.5000, -0.8400, 2.40000),
+    vec3( 0.8400, -1.5000, 2.40000), vec3( 0.0000, -1.5000, 2.40000),
+    vec3( 1.7500,  0.0000, 1.87500), vec3( 1.7500, -0.9800, 1.87500),
+    vec3( 0.9800, -1.7500, 1.87500), vec3( 0.0000, -1.7500, 1.87500),
+    vec3( 2.0000,  0.0000, 1.35000), vec3( 2.0000, -1.1200, 1.35000),
+    vec3( 1.1200, -2.0000, 1.35000), vec3( 0.0000, -2.0000, 1.35000),
+    vec3( 2.0000,  0.0000, 0.90000), vec3( 2.0000, -1.1200, 0.90000),
+    vec3( 1.1200, -2.0000, 0.90000), vec3( 0.0000, -2.0000, 0.90000),
+    vec3(-2.0000,  0.0000, 0.90000), vec3( 2.0000,  0.0000, 0.45000),
+    vec3( 2.0000, -1.1200, 0.45000), vec3( 1.1200, -2.0000, 0.45000),
+    vec3( 0.0000, -2.0000, 0.45000), vec3( 1.5000,  0.0000, 0.22500),
+    vec3( 1.5000, -0.8400, 0.22500), vec3( 0.8400, -1.5000, 0.22500),
+    vec3( 0.0000, -1.5000, 0.22500), vec3( 1.5000,  0.0000, 0.15000),
+    vec3( 1.5000, -0.8400, 0.15000), vec3( 0.8400, -1.5000, 0.15000),
+    vec3( 0.0000, -1.5000, 0.15000), vec3(-1.6000,  0.0000, 2.02500),
+    vec3(-1.6000, -0.3000, 2.02500), vec3(-1.5000, -0.3000, 2.25000),
+    vec3(-1.5000,  0.0000, 2.25000), vec3(-2.3000,  0.0000, 2.02500),
+    vec3(-2.3000, -0.3000, 2.02500), vec3(-2.5000, -0.3000, 2.25000),
+    vec3(-2.5000,  0.0000, 2.25000), vec3(-2.7000,  0.0000, 2.02500),
+    vec3(-2.7000, -0.3000, 2.02500), vec3(-3.0000, -0.3000, 2.25000),
+    vec3(-3.0000,  0.0000, 2.25000), vec3(-2.7000,  0.0000, 1.80000),
+    vec3(-2.7000, -0.3000, 1.80000), vec3(-3.0000, -0.3000, 1.80000),
+    vec3(-3.0000,  0.0000, 1.80000), vec3(-2.7000,  0.0000, 1.57500),
+    vec3(-2.7000, -0.3000, 1.57500), vec3(-3.0000, -0.3000, 1.35000),
+    vec3(-3.0000,  0.0000, 1.35000), vec3(-2.5000,  0.0000, 1.12500),
+    vec3(-2.5000, -0.3000, 1.12500), vec3(-2.6500, -0.3000, 0.93750),
+    vec3(-2.6500,  0.0000, 0.93750), vec3(-2.0000, -0.3000, 0.90000),
+    vec3(-1.9000, -0.3000, 0.60000), vec3(-1.9000,  0.0000, 0.60000),
+    vec3( 1.7000,  0.0000, 1.42500), vec3( 1.7000, -0.6600, 1.42500),
+    vec3( 1.7000, -0.6600, 0.60000), vec3( 1.7000,  0.0000, 0.60000),
+    vec3( 2.6000,  0.0000, 1.42500), vec3( 2.6000, -0.6600, 1.42500),
+    vec3( 3.1000, -0.6600, 0.82500), vec3( 3.1000,  0.0000, 0.82500),
+    vec3( 2.3000,  0.0000, 2.10000), vec3( 2.3000, -0.2500, 2.10000),
+    vec3( 2.4000, -0.2500, 2.02500), vec3( 2.4000,  0.0000, 2.02500),
+    vec3( 2.7000,  0.0000, 2.40000), vec3( 2.7000, -0.2500, 2.40000),
+    vec3( 3.3000, -0.2500, 2.40000), vec3( 3.3000,  0.0000, 2.40000),
+    vec3( 2.8000,  0.0000, 2.47500), vec3( 2.8000, -0.2500, 2.47500),
+    vec3( 3.5250, -0.2500, 2.49375), vec3( 3.5250,  0.0000, 2.49375),
+    vec3( 2.9000,  0.0000, 2.47500), vec3( 2.9000, -0.1500, 2.47500),
+    vec3( 3.4500, -0.1500, 2.51250), vec3( 3.4500,  0.0000, 2.51250),
+    vec3( 2.8000,  0.0000, 2.40000), vec3( 2.8000, -0.1500, 2.40000),
+    vec3( 3.2000, -0.1500, 2.40000), vec3( 3.2000,  0.0000, 2.40000),
+    vec3( 0.0000,  0.0000, 3.15000), vec3( 0.8000,  0.0000, 3.15000),
+    vec3( 0.8000, -0.4500, 3.15000), vec3( 0.4500, -0.8000, 3.15000),
+    vec3( 0.0000, -0.8000, 3.15000), vec3( 0.0000,  0.0000, 2.85000),
+    vec3( 1.4000,  0.0000, 2.40000), vec3( 1.4000, -0.7840, 2.40000),
+    vec3( 0.7840, -1.4000, 2.40000), vec3( 0.0000, -1.4000, 2.40000),
+    vec3( 0.4000,  0.0000, 2.55000), vec3( 0.4000, -0.2240, 2.55000),
+    vec3( 0.2240, -0.4000, 2.55000), vec3( 0.0000, -0.4000, 2.55000),
+    vec3( 1.3000,  0.0000, 2.55000), vec3( 1.3000, -0.7280, 2.55000),
+    vec3( 0.7280, -1.3000, 2.55000), vec3( 0.0000, -1.3000, 2.55000),
+    vec3( 1.3000,  0.0000, 2.40000), vec3( 1.3000, -0.7280, 2.40000),
+    vec3( 0.7280, -1.3000, 2.40000), vec3( 0.0000, -1.3000, 2.40000)
+};
+
+// Bezier patches
+int patches[][16] = {
+    {102, 103, 104, 105,   4,   5,   6,   7,   8,   9,  10,  11,  12,  13,  14,  15},   // rim (reflect x&y)
+    { 12,  13,  14,  15,  16,  17,  18,  19,  20,  21,  22,  23,  24,  25,  26,  27},   // body (reflect x&y)
+    { 24,  25,  26,  27,  29,  30,  31,  32,  33,  34,  35,  36,  37,  38,  39,  40},   // body (reflect x&y)
+    { 96,  96,  96,  96,  97,  98,  99, 100, 101, 101, 101, 101,   0,   1,   2,   3},   // lid (reflect x&y)
+    {  0,   1,   2,   3, 106, 107, 108, 109, 110, 111, 112, 113, 114, 115, 116, 117},   // lid (reflect x&y)
+    { 41,  42,  43,  44,  45,  46,  47,  48,  49,  50,  51,  52,  53,  54,  55,  56},   // handle (reflect y)
+    { 53,  54,  55,  56,  57,  58,  59,  60,  61,  62,  63,  64,  28,  65,  66,  67},   // handle (reflect y)
+    { 68,  69,  70,  71,  72,  73,  74,  75,  76,  77,  78,  79,  80,  81,  82,  83},   // spout (reflect y)
+    { 80,  81,  82,  83,  84,  85,  86,  87,  88,  89,  90,  91,  92,  93,  94,  95}    // spout (reflect y)
+};
+
+const int   nCtrlPts = sizeof(controlPoints)/sizeof(controlPoints[0]);
+
+// display parameters
+int         winWidth = 800, winHeight = 600;
+Camera      camera(winWidth, winHeight, vec3(0, 0, 0), vec3(0, 0, -7));
+const mat4  model = Scale(.5f)*RotateX(-90)*Translate(0, 0, -1.5f);    // upright, centered teapot
+
+// shading
+GLuint      program = 0;
+vec3        light(-2, 3, 4);
+
+// tessellation: all patches share one vertex buffer, patch p at vertices p*NVertices()
+const int   nPatches = sizeof(patches)/sizeof(patches[0]);
+const int   nMirrored = 5;              // patches 0-4 reflect in x and y (4 instances), the rest in y (2)
+vec3        ctrlPts[nPatches][4][4];    // indexed [t][s]
+int         res = 16;
+PatchTessellator tess;
+JobPool     pool;
+std::vector<vec3> points, normals;
+Mesh        mesh;
+IndexBuffer indices;
+bool        patchChanged[nPatches];     // a control point moved since the patch was tessellated
+
+// interaction (control points are edited in the unreflected patches)
+bool        viewCtrlPts = false;
+void*       picked = NULL;
+Mover       mover;
+PointPicker picker;
+Overlay     overlay;
+int         pickedId = -1;          // control point held by the mover
+int         xCursorOffset = -7, yCursorOffset = -3;
+
+// per-instance reflections: identity, y, x, x&y (so the first two suit the handle and spout)
+mat4 mirrors[] = { Scale(1, 1, 1), Scale(1, -1, 1), Scale(-1, 1, 1), Scale(-1, -1, 1) };
+
+void SetControlPoints() {
+    for (int p = 0; p < nPatches; p++)
+        for (int k = 0; k < 16; k++)
+            ctrlPts[p][k/4][k%4] = controlPoints[patches[p][k]];
+}
+
+void ControlPointMoved(int id) {
+    // copy control point id to the patches that use it, and flag them
+    for (int p = 0; p < nPatches; p++)
+        for (int k = 0; k < 16; k++)
+            if (patches[p][k] == id) {
+                ctrlPts[p][k/4][k%4] = controlPoints[id];
+                patchChanged[p] = true;
+            }
+}
+
+double TessellatePatches(JobPool &jobs) {
+    // one job per patch; return elapsed milliseconds
+    int nv = tess.NVertices();
+    points.resize(nPatches*nv);
+    normals.resize(nPatches*nv);
+    auto start = std::chrono::steady_clock::now();
+    jobs.Run(nPatches, [&](int p) {
+        tess.Tessellate(ctrlPts[p], points.data()+p*nv, normals.data()+p*nv);
+    });
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now()-start).count();
+}
+
+void SetVertices(int r) {
+    tess.SetResolution(r);
+    res = tess.Resolution();
+    double ms = TessellatePatches(pool);
+    int nv = tess.NVertices(), size = nPatches*nv*sizeof(vec3);
+    mesh.Allocate(2*size, NULL);
+    mesh.SubData(0, size, points.data());
+    mesh.SubData(size, size, normals.data());
+    mesh.Attribute(program, "point", 3, 0, 0);
+    mesh.Attribute(program, "normal", 3, 0, size);
+    // patch index lists, offset to each patch's vertices
+    const std::vector<int> &grid = tess.Triangles();
+    std::vector<int> ids(nPatches*grid.size());
+    for (int p = 0; p < nPatches; p++)
+        for (size_t i = 0; i < grid.size(); i++)
+            ids[p*grid.size()+i] = grid[i]+p*nv;
+    indices.Allocate(ids.data(), ids.size(), nPatches*nv);
+    mesh.Attach(indices);
+    for (int p = 0; p < nPatches; p++)
+        patchChanged[p] = false;
+    int nTris = nPatches*2*res*res;
+    printf("res = %i: %i triangles stored, %i drawn, tessellated in %.2f ms (%i threads)\n",
+           res, nTris, 2*res*res*(4*nMirrored+2*(nPatches-nMirrored)), ms, pool.NThreads());
+}
+
+void UpdatePatches() {
+    // re-tessellate (one job per changed patch) and re-upload only the changed patches
+    std::vector<int> changed;
+    for (int p = 0; p < nPatches; p++)
+        if (patchChanged[p])
+            changed.push_back(p);
+    if (changed.empty())
+        return;
+    int nv = tess.NVertices(), patchSize = nv*sizeof(vec3), size = nPatches*patchSize;
+    pool.Run((int) changed.size(), [&](int i) {
+        int p = changed[i];
+        tess.Tessellate(ctrlPts[p], points.data()+p*nv, normals.data()+p*nv);
+    });
+    for (int p : changed) {
+        mesh.SubData(p*patchSize, patchSize, points.data()+p*nv);
+        mesh.SubData(size+p*patchSize, patchSize, normals.data()+p*nv);
+        patchChanged[p] = false;
+    }
+}
+
+void BenchmarkTessellation() {
+    // patch triangles per second, serial vs job pool, as JSON
+    SetControlPoints();
+    JobPool serial(1);
+    int resolutions[] = { 8, 32, 128, 512 };
+    printf("{\n  \"threads\": %i,\n  \"patches\": %i,\n  \"runs\": [\n", pool.NThreads(), nPatches);
+    for (int i = 0; i < 4; i++) {
+        tess.SetResolution(resolutions[i]);
+        double tris = nPatches*2.*resolutions[i]*resolutions[i], ms[2];
+        for (int k = 0; k < 2; k++) {
+            JobPool &jobs = k? pool : serial;
+            int n = 0;
+            double total = 0;
+            while (n < 3 || total < 200)
+                total += TessellatePatches(jobs), n++;
+            ms[k] = total/n;
+        }
+        printf("    {\"res\": %i, \"triangles\": %.0f, \"serial_ms\": %.3f, \"pool_ms\": %.3f, \"pool_tris_per_sec\": %.0f}%s\n",
+               resolutions[i], tris, ms[0], ms[1], 1000*tris/ms[1], i < 3? "," : "");
+    }
+    printf("  ]\n}\n");
+}
+
+// vertex shader: instance selects the reflection; flip records whether it reverses winding
+// (model and mirror are constant, so sent once, after link)
+const char *vShaderCode = R"(
+    #version 330
+    in vec3 point, normal;
+    out vec3 vPoint, vNormal;
+    flat out float vFlip;
+    uniform mat4 mirror[4];
+    uniform mat4 model;
+    layout (std140, row_major) uniform Camera { mat4 modelview, persp, fullview; };
+    void main() {
+        mat4 m = model*mirror[gl_InstanceID];
+        vFlip = determinant(mat3(m)) < 0? -1 : 1;
+        vNormal = (modelview*m*vec4(normal, 0)).xyz;
+        vPoint = (modelview*m*vec4(point, 1)).xyz;
+        gl_Position = persp*vec4(vPoint, 1);
+    }
+)";
+
+// pixel shader: a reflected instance's front faces arrive as back faces, so
+// facing is corrected by vFlip before orienting the normal toward the viewer
+const char *pShaderCode = R"(
+    #version 330
+    in vec3 vPoint, vNormal;
+    flat in float vFlip;
+    out vec4 pColor;
+    uniform vec3 light;
+    uniform vec3 color = vec3(.8, .7, .5);
+    void main() {
+        bool front = gl_FrontFacing == (vFlip > 0);
+        vec3 N = normalize(front? vNormal : -vNormal);
+        vec3 L = normalize(light-vPoint);       // light vector
+        vec3 E = normalize(vPoint);             // eye vertex
+        vec3 R = reflect(L, N);                 // highlight vector
+        float dif = max(0, dot(N, L));
+        float spec = pow(max(0, dot(E, R)), 50);
+        float ad = clamp(.15+dif, 0, 1);
+        pColor = vec4(ad*color+vec3(spec), 1);
+    }
+)";
+
+// display
+
+vec3 World(vec3 p) {
+    // teapot to world space
+    vec4 h = model*vec4(p, 1);
+    return vec3(h.x, h.y, h.z);
+}
+
+void Display() {
+    // several drags per frame collapse into one update
+    UpdatePatches();
+    glClearColor(.6f, .6f, .6f, 1);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    glEnable(GL_DEPTH_TEST);
+    glUseProgram(program);
+    UpdateCameraBlock(camera);
+    vec4 hLight = camera.modelview*vec4(light, 1);
+    SetUniform(UniformLocation(program, "light"), vec3(hLight.x, hLight.y, hLight.z));
+    // rim, body, lid: 4 instances; handle, spout: 2
+    int nPerPatch = 6*res*res;
+    mesh.Bind();
+    indices.DrawInstanced(GL_TRIANGLES, 4, 0, nMirrored*nPerPatch);
+    indices.DrawInstanced(GL_TRIANGLES, 2, nMirrored*nPerPatch);
+    mesh.Unbind();
+    if (viewCtrlPts) {
+        // control meshes of the unreflected patches, in world space
+        glDisable(GL_DEPTH_TEST);
+        for (int p = 0; p < nPatches; p++)
+            for (int i = 0; i < 4; i++)
+                for (int j = 0; j < 3; j++) {
+                    overlay.Line(World(ctrlPts[p][i][j]), World(ctrlPts[p][i][j+1]), 1.25f, vec3(1, 1, 0));
+                    overlay.Line(World(ctrlPts[p][j][i]), World(ctrlPts[p][j+1][i]), 1.25f, vec3(1, 1, 0));
+                }
+        for (int i = 0; i < nCtrlPts; i++)
+            overlay.Disk(World(controlPoints[i]), 7, vec3(1, 1, 0));
+        overlay.Flush();
+    }
+    glFlush();
+}
+
+// mouse
+
+int WindowHeight(GLFWwindow *w) {
+    int width, height;
+    glfwGetWindowSize(w, &width, &height);
+    return height;
+}
+
+bool Shift(GLFWwindow *w) {
+    return glfwGetKey(w, GLFW_KEY_LEFT_SHIFT) == GLFW_PRESS ||
+           glfwGetKey(w, GLFW_KEY_RIGHT_SHIFT) == GLFW_PRESS;
+}
+
+void MouseButton(GLFWwindow *w, int butn, int action, int mods) {
+    double x, y;
+    glfwGetCursorPos(w, &x, &y);
+    y = WindowHeight(w)-y;
+    picked = NULL;
+    if (action == GLFW_PRESS) {
+        // nearest control point (in teapot space), cursor offset as for MouseOver
+        vec3 *pp = viewCtrlPts? picker.Pick((int) x+xCursorOffset, (int) y+yCursorOffset, camera.fullview*model) : NULL;
+        if (pp) {
+            pickedId = (int) (pp-controlPoints);
+            mover.Down(pp, (int) x, (int) y, camera.modelview*model, camera.persp);
+            picked = &mover;
+        }
+        else {
+            camera.MouseDown((int) x, (int) y);
+            picked = &camera;
+        }
+    }
+    if (action == GLFW_RELEASE)
+        camera.MouseUp();
+}
+
+void MouseMove(GLFWwindow *w, double x, double y) {
+    if (glfwGetMouseButton(w, GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS) {
+        y = WindowHeight(w)-y;
+        if (picked == &mover) {
+            // re-tessellated by the next Display()
+            mover.Drag((int) x, (int) y, camera.modelview*model, camera.persp);
+            ControlPointMoved(pickedId);
+            picker.Moved();
+        }
+        if (picked == &camera)
+            camera.MouseDrag((int) x, (int) y, Shift(w));
+        Redraw();
+    }
+}
+
+void MouseWheel(GLFWwindow *w, double ignore, double spin) {
+    camera.MouseWheel(spin > 0, Shift(w));
+    Redraw();
+}
+
+// application
+
+void Keyboard(GLFWwindow *w, int key, int scancode, int action, int mods) {
+    // C: show/edit control points
+    if (action == GLFW_PRESS && key == 'C') {
+        viewCtrlPts = !viewCtrlPts;
+        Redraw();
+    }
+    // up/down arrows: double/halve resolution
+    if (action == GLFW_PRESS && (key == GLFW_KEY_UP || key == GLFW_KEY_DOWN)) {
+        SetVertices(key == GLFW_KEY_UP? 2*res : res/2);
+        Redraw();
+    }
+}
+
+void Resize(GLFWwindow *window, int width, int height) {
+    camera.Resize(width, height);
+    glViewport(0, 0, width, height);
+    Redraw();
+}
+
+int main(int ac, char **av) {
+    // --tess: CPU tessellation benchmark only, no window
+    for (int i = 1; i < ac; i++)
+        if (!strcmp(av[i], "--tess")) {
+            BenchmarkTessellation();
+            return 0;
+        }
+    // --res n sets resolution
+    for (int i = 1; i < ac-1; i++)
+        if (!strcmp(av[i], "--res"))
+            res = atoi(av[i+1]);
+    // init app window (offscreen if benchmarking)
+    bool bench = HeadlessArgs(ac, av);
+    GLFWwindow *w = NULL;
+    if (bench) {
+        if (!InitHeadless(winWidth, winHeight))
+            return 1;
+    }
+    else {
+        if (!glfwInit())
+            return 1;
+        w = glfwCreateWindow(winWidth, winHeight, "Utah Teapot", NULL, NULL);
+        glfwSetWindowPos(w, 100, 100);
+        glfwMakeContextCurrent(w);
+        gladLoadGLLoader((GLADloadproc) glfwGetProcAddress);
+    }
+    program = LinkProgramViaCache(&vShaderCode, &pShaderCode);
+    CacheLocations(program);
+    BindCameraBlock(program);
+    glUseProgram(program);
+    SetUniform(UniformLocation(program, "model"), model);
+    SetUniformMat4v(UniformLocation(program, "mirror"), 4, mirrors);
+    SetControlPoints();
+    SetVertices(res);
+    picker.Add(controlPoints, nCtrlPts);
+    if (bench)
+        return RunHeadless("Teapot", Display, &camera);
+    // callbacks
+    glfwSetCursorPosCallback(w, MouseMove);
+    glfwSetMouseButtonCallback(w, MouseButton);
+    glfwSetScrollCallback(w, MouseWheel);
+    glfwSetWindowSizeCallback(w, Resize);
+    glfwSetKeyCallback(w, Keyboard);
+    printf("Usage: up/down arrows: resolution, C: show/drag control points\n");
+    // event loop: draw only after input or resize
+    glfwSwapInterval(1);
+    while (NextFrame(w)) {
+        Display();
+        glfwSwapBuffers(w);
+    }
+    mesh.Release();
+    indices.Release();
+    overlay.Release();
+    glfwDestroyWindow(w);
+    glfwTerminate();
+}
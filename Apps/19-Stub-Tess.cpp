@@ -1,251 +1,454 @@
-// Stub-Tess.cpp - various shapes using tessellation shader
-// Topic - a Bezier patch with interactive control points
-// Editor: Edward Lam
-
-#include <glad.h>
-#include <GLFW/glfw3.h>
-#include <stdio.h>
-#include "Camera.h"
-#include "Draw.h"
-#include "GLXtras.h"
-#include "Misc.h"
-#include "Widgets.h"
-#include "VecMat.h"
-
-// display parameters
-int         winWidth = 800, winHeight = 600;
-Camera      camera(winWidth, winHeight, vec3(0, 0, 0), vec3(0, 0, -7));
-
-// shading
-GLuint      program = 0;
-int			textureName = 0, textureUnit = 0;
-const char *textureFilename = "C:/Users/edward/Desktop/CPSC5700/linedface/image2.tga";
-
-// Bezier patch
-vec3 ctrlPts[4][4];
-
-// interaction
-vec3        light(1.5f, 1.5f, 1);
-void*       picked = NULL;
-Mover       mover;
-
-// point controller
-bool			viewMesh = true;
-int				xCursorOffset = -7, yCursorOffset = -3;
-
-// vertex shader (no op)
-const char *vShaderCode = "void main() { gl_Position = vec4(0); } // no-op";
-
-// tessellation evaluation
-const char* teShaderCode = R"(
-	#version 400 core
-	layout (quads, equal_spacing, ccw) in;
-	uniform vec3 ctrlPts[16];
-    uniform mat4 modelview;
-	uniform mat4 persp;
-	out vec3 teNormal;
-	out vec3 tePoint;
-	out vec2 teUv;
-	vec3 BezTangent(float t, vec3 b1, vec3 b2, vec3 b3, vec3 b4) {
-		float t2 = t*t;
-		return (-3*t2+6*t-3)*b1+(9*t2-12*t+3)*b2+(6*t-9*t2)*b3+3*t2*b4;
-	}
-	vec3 BezPoint(float t, vec3 b1, vec3 b2, vec3 b3, vec3 b4) {
-		float t2 = t*t, t3 = t*t2;
-		return (-t3+3*t2-3*t+1)*b1+(3*t3-6*t2+3*t)*b2+(3*t2-3*t3)*b3+t3*b4;
-	}
-	void main() {
-		vec3 spts[4], tpts[4];
-        float s = gl_TessCoord.st.s, t = gl_TessCoord.st.t;
-		teUv = vec2(s,t);
-		for (int i = 0; i < 4; i++) {
-			spts[i] = BezPoint(s, ctrlPts[4*i], ctrlPts[4*i+1], ctrlPts[4*i+2], ctrlPts[4*i+3]);
-			tpts[i] = BezPoint(t, ctrlPts[i], ctrlPts[i+4], ctrlPts[i+8], ctrlPts[i+12]);
-		}
-		vec3 p = BezPoint(t, spts[0], spts[1], spts[2], spts[3]);
-		vec3 tTan = BezTangent(t, spts[0], spts[1], spts[2], spts[3]);
-		vec3 sTan = BezTangent(s, tpts[0], tpts[1], tpts[2], tpts[3]);
-		vec3 n = normalize(cross(sTan, tTan));
-		teNormal = (modelview*vec4(n, 0)).xyz;
-		tePoint = (modelview*vec4(p, 1)).xyz;
-		gl_Position = persp*vec4(tePoint, 1);
-	}
-)";
-
-// pixel shader
-const char* pShaderCode = R"(
-    #version 400
-    in vec3 tePoint, teNormal;
-    in vec2 teUv;
-    uniform sampler2D textureMap;
-    uniform vec3 light;
-    void main() {
-        vec3 N = normalize(teNormal);             // surface normal
-        vec3 L = normalize(light-tePoint);        // light vector
-        vec3 E = normalize(tePoint);                // eye vertex
-        vec3 R = reflect(L, N);                    // highlight vector
-        float dif = max(0, dot(N, L));            // one-sided diffuse
-        float spec = pow(max(0, dot(E, R)), 50);
-        float ad = clamp(.15+dif, 0, 1);
-        vec3 texColor = texture(textureMap, teUv).rgb;
-        gl_FragColor = vec4(ad*texColor+vec3(spec), 1);
-    }
-)";
-
-// display
-
-void Display() {
-    // background, blending, zbuffer
-    glClearColor(.6f, .6f, .6f, 1);
-    glClear(GL_COLOR_BUFFER_BIT);
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-    glEnable(GL_DEPTH_TEST);
-    glClear(GL_DEPTH_BUFFER_BIT);
-    glUseProgram(program);
-    // ctrl points
-    GLint id = glGetUniformLocation(program, "ctrlPts");
-    glUniform3fv(id, 16, (float*)&ctrlPts[0][0]);
-    // update matrices
-    SetUniform(program, "modelview", camera.modelview);
-    SetUniform(program, "persp", camera.persp);
-	// set texture
-	SetUniform(program, "textureMap", textureUnit);
-    glActiveTexture(GL_TEXTURE0+textureUnit);       // active texture corresponds with textureUnit
-	glBindTexture(GL_TEXTURE_2D, textureName);      // bind active texture to textureName
-	// transform light and send to pixel shader
-    vec4 hLight = camera.modelview*vec4(light, 1);
-    glUniform3fv(glGetUniformLocation(program, "light"), 1, (float *) &hLight);
-    // tessellate patch
-    glPatchParameteri(GL_PATCH_VERTICES, 4);
-    float res = 25, outerLevels[] = {res, res, res, res}, innerLevels[] = {res, res};
-    glPatchParameterfv(GL_PATCH_DEFAULT_OUTER_LEVEL, outerLevels);
-    glPatchParameterfv(GL_PATCH_DEFAULT_INNER_LEVEL, innerLevels);
-    glDrawArrays(GL_PATCHES, 0, 4);
-    // light
-    glDisable(GL_DEPTH_TEST);
-    UseDrawShader(camera.fullview);
-
-
-    if (viewMesh) {
-        for (int i = 0; i < 4; i++)
-            for (int j = 0; j < 3; j++) {
-                Line(ctrlPts[i][j], ctrlPts[i][j + 1], 1.25f, vec3(1, 1, 0));
-                Line(ctrlPts[j][i], ctrlPts[j + 1][i], 1.25f, vec3(1, 1, 0));
-            }
-        for (int i = 0; i < 16; i++)
-            Disk(ctrlPts[i / 4][i % 4], 7, vec3(1, 1, 0));
-    }
-
-    Disk(light, 12, vec3(1, 0, 0));
-    glFlush();
-}
-
-// mouse
-
-int WindowHeight(GLFWwindow *w) {
-    int width, height;
-    glfwGetWindowSize(w, &width, &height);
-    return height;
-}
-
-bool Shift(GLFWwindow *w) {
-    return glfwGetKey(w, GLFW_KEY_LEFT_SHIFT) == GLFW_PRESS ||
-           glfwGetKey(w, GLFW_KEY_RIGHT_SHIFT) == GLFW_PRESS;
-}
-
-vec3* PickControlPoint(int x, int y) {
-    for (int k = 0; k < 16; k++)
-        if (MouseOver(x, y, ctrlPts[k / 4][k % 4], camera.fullview, xCursorOffset, yCursorOffset))
-            return &ctrlPts[k / 4][k % 4];
-    return NULL;
-}
-
-void MouseButton(GLFWwindow *w, int butn, int action, int mods) {
-    double x, y;
-    glfwGetCursorPos(w, &x, &y);
-    y = WindowHeight(w)-y; // invert y for upward-increasing screen space
-    picked = NULL;
-    if (action == GLFW_RELEASE)
-        camera.MouseUp();
-    if (action == GLFW_PRESS) {
-        vec3* pp = viewMesh ? PickControlPoint(x, y) : NULL;
-        if (pp) {
-            if (butn == GLFW_MOUSE_BUTTON_LEFT) {
-                mover.Down(pp, x, y, camera.modelview, camera.persp);
-                picked = &mover;
-            }
-        }
-        else if (MouseOver(x, y, light, camera.fullview, xCursorOffset, yCursorOffset)) {
-            mover.Down(&light, x, y, camera.modelview, camera.persp);
-            picked = &mover;
-        }
-		else {
-			picked = &camera;
-			camera.MouseDown(x, y);
-		}
-	}
-}
-
-
-
-void MouseMove(GLFWwindow *w, double x, double y) {
-    if (glfwGetMouseButton(w, GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS) {
-		y = WindowHeight(w)-y;
-		if (picked == &mover)
-			mover.Drag((int) x, (int) y, camera.modelview, camera.persp);
-		if (picked == &camera)
-			camera.MouseDrag((int) x, (int) y, Shift(w));
-	}
-}
-
-void MouseWheel(GLFWwindow *w, double ignore, double spin) {
-    camera.MouseWheel(spin > 0, Shift(w));
-}
-
-
-
-// application
-
-void Resize(GLFWwindow *window, int width, int height) {
-    glViewport(0, 0, width, height);
-}
-
-// configure default control points
-void DefaultControlPoints() {
-    vec3 p0 = vec3(-.8f, -.8f, 0), p1 = vec3(.8f, -.8f, 0), p2 = vec3(-.8f, .8f, 0), p3 = vec3(.8f, .8f, 0);
-    float vals[] = { 0, 1 / 3.f, 2 / 3.f, 1. };
-    for (int i = 0; i < 16; i++) {
-        float ax = vals[i % 4], ay = vals[i / 4];
-        vec3 p10 = p0 + ax * (p1 - p0), p32 = p2 + ax * (p3 - p2);
-        ctrlPts[i / 4][i % 4] = p10 + ay * (p32 - p10);
-    }
-}
-
-int main(int ac, char **av) {
-    // init app window
-    if (!glfwInit())
-        return 1;
-    GLFWwindow *w = glfwCreateWindow(winWidth, winHeight, "Bezier Patch w Interactive Points by Edwrd Lam", NULL, NULL);
-    glfwSetWindowPos(w, 100, 100);
-    glfwMakeContextCurrent(w);
-    // init OpenGL, shader program, texture
-    gladLoadGLLoader((GLADloadproc) glfwGetProcAddress);
-    program = LinkProgramViaCode(&vShaderCode, NULL, &teShaderCode, NULL, &pShaderCode);
-    DefaultControlPoints();
-    textureName = LoadTexture(textureFilename, textureUnit);
-    // callbacks
-    glfwSetCursorPosCallback(w, MouseMove);
-    glfwSetMouseButtonCallback(w, MouseButton);
-    glfwSetScrollCallback(w, MouseWheel);
-    glfwSetWindowSizeCallback(w, Resize);
-    // event loop
-    glfwSwapInterval(1);
-    while (!glfwWindowShouldClose(w)) {
-        Display();
-        glfwPollEvents();
-        glfwSwapBuffers(w);
-    }
-    glfwDestroyWindow(w);
-    glfwTerminate();
-}
+// Stub-Tess.cpp - various shapes using tessellation shader
+// Topic - a Bezier patch with interactive control points
+// Editor: Edward Lam
+
+#include <glad.h>
+#include <GLFW/glfw3.h>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include "AsyncTexture.h"
+#include "Camera.h"
+#include "CameraBlock.h"
+#include "GLXtras.h"
+#include "GpuTimer.h"
+#include "Headless.h"
+#include "Mesh.h"
+#include "Misc.h"
+#include "Overlay.h"
+#include "Picker.h"
+#include "ProgramCache.h"
+#include "Redraw.h"
+#include "Tessellate.h"
+#include "Uniforms.h"
+#include "Widgets.h"
+#include "VecMat.h"
+
+// display parameters
+int         winWidth = 800, winHeight = 600;
+Camera      camera(winWidth, winHeight, vec3(0, 0, 0), vec3(0, 0, -7));
+
+// shading
+GLuint      program = 0;
+int			textureName = 0, textureUnit = 0;
+AsyncTexture asyncTexture;     // placeholder until the image is read and uploaded
+const char *textureFilename = "C:/Users/edward/Desktop/CPSC5700/linedface/image2.tga";
+
+// Bezier patch
+vec3 ctrlPts[4][4];
+bool ctrlPtsChanged = true;     // upload ctrlPts uniform only after a control point moves
+
+// adaptive tessellation: levels follow the projected size of the control hull
+float pixelsPerSegment = 8;     // target on-screen length of a tessellated edge segment
+
+// CPU fallback, where tessellation shaders (GL 4.0) are unavailable
+bool cpuTessellate = false;
+GLuint cpuProgram = 0;
+PatchTessellator tess;
+std::vector<vec3> points, normals;
+Mesh mesh;
+IndexBuffer indices;
+
+// interaction
+vec3        light(1.5f, 1.5f, 1);
+void*       picked = NULL;
+Mover       mover;
+PointPicker picker;                 // control points, projected once per view change
+Overlay     overlay;                // control mesh and light, drawn in one call
+GpuTimer    gpuTimer;               // GPU time of patch and overlay (T to print)
+bool        movingCtrlPt = false;   // mover holds a control point (else the light)
+
+// point controller
+bool			viewMesh = true;
+int				xCursorOffset = -7, yCursorOffset = -3;
+
+// vertex shader (no op)
+const char *vShaderCode = "void main() { gl_Position = vec4(0); } // no-op";
+
+// tessellation control: per-edge levels from the projected control polygon of each edge
+// (as PatchLevels() in Tessellate.cpp); an edge's level uses only its own four control
+// points, summed in an order-independent way, so patches sharing an edge agree on it
+const char *tcShaderCode = R"(
+    #version 400 core
+    layout (vertices = 4) out;
+    uniform vec3 ctrlPts[16];
+    layout (std140, row_major) uniform Camera { mat4 modelview, persp, fullview; };
+    uniform vec2 viewport;
+    uniform float pixelsPerSegment = 8;
+    vec2 ScreenPoint(vec3 p) {
+        vec4 c = persp*modelview*vec4(p, 1);
+        return .5*viewport*c.xy/max(c.w, .001);
+    }
+    float EdgeLevel(int i, int stride) {
+        vec2 a = ScreenPoint(ctrlPts[i]), b = ScreenPoint(ctrlPts[i+stride]);
+        vec2 c = ScreenPoint(ctrlPts[i+2*stride]), d = ScreenPoint(ctrlPts[i+3*stride]);
+        float len = (distance(a, b)+distance(c, d))+distance(b, c);
+        return clamp(ceil(len/pixelsPerSegment), 1, 64);
+    }
+    void main() {
+        if (gl_InvocationID == 0) {
+            // outer edges s = 0, t = 0, s = 1, t = 1 (ctrlPts indexed 4*t+s)
+            float e0 = EdgeLevel(0, 4), e1 = EdgeLevel(0, 1), e2 = EdgeLevel(3, 4), e3 = EdgeLevel(12, 1);
+            gl_TessLevelOuter[0] = e0;
+            gl_TessLevelOuter[1] = e1;
+            gl_TessLevelOuter[2] = e2;
+            gl_TessLevelOuter[3] = e3;
+            gl_TessLevelInner[0] = max(e1, e3);
+            gl_TessLevelInner[1] = max(e0, e2);
+        }
+    }
+)";
+
+// tessellation evaluation
+const char* teShaderCode = R"(
+	#version 400 core
+	layout (quads, equal_spacing, ccw) in;
+	uniform vec3 ctrlPts[16];
+    layout (std140, row_major) uniform Camera { mat4 modelview, persp, fullview; };
+	out vec3 teNormal;
+	out vec3 tePoint;
+	out vec2 teUv;
+	vec3 BezTangent(float t, vec3 b1, vec3 b2, vec3 b3, vec3 b4) {
+		float t2 = t*t;
+		return (-3*t2+6*t-3)*b1+(9*t2-12*t+3)*b2+(6*t-9*t2)*b3+3*t2*b4;
+	}
+	vec3 BezPoint(float t, vec3 b1, vec3 b2, vec3 b3, vec3 b4) {
+		float t2 = t*t, t3 = t*t2;
+		return (-t3+3*t2-3*t+1)*b1+(3*t3-6*t2+3*t)*b2+(3*t2-3*t3)*b3+t3*b4;
+	}
+	void main() {
+		vec3 spts[4], tpts[4];
+        float s = gl_TessCoord.st.s, t = gl_TessCoord.st.t;
+		teUv = vec2(s,t);
+		for (int i = 0; i < 4; i++) {
+			spts[i] = BezPoint(s, ctrlPts[4*i], ctrlPts[4*i+1], ctrlPts[4*i+2], ctrlPts[4*i+3]);
+			tpts[i] = BezPoint(t, ctrlPts[i], ctrlPts[i+4], ctrlPts[i+8], ctrlPts[i+12]);
+		}
+		vec3 p = BezPoint(t, spts[0], spts[1], spts[2], spts[3]);
+		vec3 tTan = BezTangent(t, spts[0], spts[1], spts[2], spts[3]);
+		vec3 sTan = BezTangent(s, tpts[0], tpts[1], tpts[2], tpts[3]);
+		vec3 n = normalize(cross(sTan, tTan));
+		teNormal = (modelview*vec4(n, 0)).xyz;
+		tePoint = (modelview*vec4(p, 1)).xyz;
+		gl_Position = persp*vec4(tePoint, 1);
+	}
+)";
+
+// pixel shader
+const char* pShaderCode = R"(
+    #version 400
+    in vec3 tePoint, teNormal;
+    in vec2 teUv;
+    uniform sampler2D textureMap;
+    uniform vec3 light;
+    void main() {
+        vec3 N = normalize(teNormal);             // surface normal
+        vec3 L = normalize(light-tePoint);        // light vector
+        vec3 E = normalize(tePoint);                // eye vertex
+        vec3 R = reflect(L, N);                    // highlight vector
+        float dif = max(0, dot(N, L));            // one-sided diffuse
+        float spec = pow(max(0, dot(E, R)), 50);
+        float ad = clamp(.15+dif, 0, 1);
+        vec3 texColor = texture(textureMap, teUv).rgb;
+        gl_FragColor = vec4(ad*texColor+vec3(spec), 1);
+    }
+)";
+
+// CPU fallback shaders: uv from the grid vertex id, vertex (s, t) at t*(res+1)+s
+const char *cpuVShaderCode = R"(
+    #version 140
+    in vec3 point, normal;
+    out vec3 tePoint, teNormal;
+    out vec2 teUv;
+    layout (std140, row_major) uniform Camera { mat4 modelview, persp, fullview; };
+    uniform int res;
+    void main() {
+        teUv = vec2(gl_VertexID%(res+1), gl_VertexID/(res+1))/float(res);
+        teNormal = (modelview*vec4(normal, 0)).xyz;
+        tePoint = (modelview*vec4(point, 1)).xyz;
+        gl_Position = persp*vec4(tePoint, 1);
+    }
+)";
+
+const char *cpuPShaderCode = R"(
+    #version 130
+    in vec3 tePoint, teNormal;
+    in vec2 teUv;
+    uniform sampler2D textureMap;
+    uniform vec3 light;
+    void main() {
+        vec3 N = normalize(teNormal);
+        vec3 L = normalize(light-tePoint);
+        vec3 E = normalize(tePoint);
+        vec3 R = reflect(L, N);
+        float dif = max(0, dot(N, L));
+        float spec = pow(max(0, dot(E, R)), 50);
+        float ad = clamp(.15+dif, 0, 1);
+        vec3 texColor = texture(textureMap, teUv).rgb;
+        gl_FragColor = vec4(ad*texColor+vec3(spec), 1);
+    }
+)";
+
+void TessellateOnCPU(int res) {
+    // one uniform grid at the patch's largest level (a lone patch has no neighbors to crack against)
+    bool resized = res != tess.Resolution();
+    tess.SetResolution(res);
+    int nVertices = tess.NVertices(), size = nVertices*sizeof(vec3);
+    points.resize(nVertices);
+    normals.resize(nVertices);
+    tess.Tessellate(ctrlPts, points.data(), normals.data());
+    if (resized) {
+        mesh.Allocate(2*size, NULL, GL_DYNAMIC_DRAW);
+        mesh.Attribute(cpuProgram, "point", 3, 0, 0);
+        mesh.Attribute(cpuProgram, "normal", 3, 0, size);
+        indices.Allocate(tess.Triangles().data(), tess.Triangles().size(), nVertices);
+        mesh.Attach(indices);
+    }
+    mesh.SubData(0, size, points.data());
+    mesh.SubData(size, size, normals.data());
+}
+
+// display
+
+void Display() {
+    // background, blending, zbuffer
+    glClearColor(.6f, .6f, .6f, 1);
+    glClear(GL_COLOR_BUFFER_BIT);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glEnable(GL_DEPTH_TEST);
+    glClear(GL_DEPTH_BUFFER_BIT);
+    GLint viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    if (cpuTessellate) {
+        // same levels as the control shader; re-tessellate if they or the control points change
+        float outer[4], inner[2], level = 1;
+        PatchLevels(ctrlPts, camera.fullview, viewport[2], viewport[3], pixelsPerSegment, outer, inner);
+        for (int i = 0; i < 4; i++)
+            level = outer[i] > level? outer[i] : level;
+        if (ctrlPtsChanged || (int) level != tess.Resolution())
+            TessellateOnCPU((int) level);
+        ctrlPtsChanged = false;
+    }
+    GLuint p = cpuTessellate? cpuProgram : program;
+    glUseProgram(p);
+    // ctrl points (uniform values persist in the program until changed)
+    if (ctrlPtsChanged) {
+        SetUniform3v(UniformLocation(program, "ctrlPts"), 16, (float*)&ctrlPts[0][0]);
+        ctrlPtsChanged = false;
+    }
+    // update matrices (shared by both programs, sent only if the camera changed)
+    UpdateCameraBlock(camera);
+	// set texture (once read, the image replaces the placeholder)
+    textureName = asyncTexture.Update();
+	SetUniform(UniformLocation(p, "textureMap"), textureUnit);
+    glActiveTexture(GL_TEXTURE0+textureUnit);       // active texture corresponds with textureUnit
+	glBindTexture(GL_TEXTURE_2D, textureName);      // bind active texture to textureName
+	// transform light and send to pixel shader
+    vec4 hLight = camera.modelview*vec4(light, 1);
+    SetUniform3v(UniformLocation(p, "light"), 1, (float *) &hLight);
+    gpuTimer.Begin("patch");
+    if (cpuTessellate) {
+        SetUniform(UniformLocation(p, "res"), tess.Resolution());
+        mesh.Bind();
+        indices.Draw(GL_TRIANGLES);
+        mesh.Unbind();
+    }
+    else {
+        // tessellate patch, levels set by the control shader
+        SetUniform(UniformLocation(p, "viewport"), vec2((float) viewport[2], (float) viewport[3]));
+        SetUniform(UniformLocation(p, "pixelsPerSegment"), pixelsPerSegment);
+        glPatchParameteri(GL_PATCH_VERTICES, 4);
+        glDrawArrays(GL_PATCHES, 0, 4);
+    }
+    gpuTimer.End();
+    // light
+    gpuTimer.Begin("overlay");
+    glDisable(GL_DEPTH_TEST);
+    if (viewMesh) {
+        for (int i = 0; i < 4; i++)
+            for (int j = 0; j < 3; j++) {
+                overlay.Line(ctrlPts[i][j], ctrlPts[i][j + 1], 1.25f, vec3(1, 1, 0));
+                overlay.Line(ctrlPts[j][i], ctrlPts[j + 1][i], 1.25f, vec3(1, 1, 0));
+            }
+        for (int i = 0; i < 16; i++)
+            overlay.Disk(ctrlPts[i / 4][i % 4], 7, vec3(1, 1, 0));
+    }
+    overlay.Disk(light, 12, vec3(1, 0, 0));
+    overlay.Flush();
+    gpuTimer.End();
+    gpuTimer.EndFrame();
+    glFlush();
+}
+
+// mouse
+
+int WindowHeight(GLFWwindow *w) {
+    int width, height;
+    glfwGetWindowSize(w, &width, &height);
+    return height;
+}
+
+bool Shift(GLFWwindow *w) {
+    return glfwGetKey(w, GLFW_KEY_LEFT_SHIFT) == GLFW_PRESS ||
+           glfwGetKey(w, GLFW_KEY_RIGHT_SHIFT) == GLFW_PRESS;
+}
+
+vec3* PickControlPoint(int x, int y) {
+    // nearest control point, cursor offset as for MouseOver
+    return picker.Pick(x+xCursorOffset, y+yCursorOffset, camera.fullview);
+}
+
+void MouseButton(GLFWwindow *w, int butn, int action, int mods) {
+    double x, y;
+    glfwGetCursorPos(w, &x, &y);
+    y = WindowHeight(w)-y; // invert y for upward-increasing screen space
+    picked = NULL;
+    if (action == GLFW_RELEASE)
+        camera.MouseUp();
+    if (action == GLFW_PRESS) {
+        vec3* pp = viewMesh ? PickControlPoint(x, y) : NULL;
+        movingCtrlPt = pp != NULL;
+        if (pp) {
+            if (butn == GLFW_MOUSE_BUTTON_LEFT) {
+                mover.Down(pp, x, y, camera.modelview, camera.persp);
+                picked = &mover;
+            }
+        }
+        else if (MouseOver(x, y, light, camera.fullview, xCursorOffset, yCursorOffset)) {
+            mover.Down(&light, x, y, camera.modelview, camera.persp);
+            picked = &mover;
+        }
+		else {
+			picked = &camera;
+			camera.MouseDown(x, y);
+		}
+	}
+    Redraw();
+}
+
+
+
+void MouseMove(GLFWwindow *w, double x, double y) {
+    if (glfwGetMouseButton(w, GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS) {
+		y = WindowHeight(w)-y;
+		if (picked == &mover) {
+			mover.Drag((int) x, (int) y, camera.modelview, camera.persp);
+			ctrlPtsChanged = ctrlPtsChanged || movingCtrlPt;
+			if (movingCtrlPt)
+				picker.Moved();
+		}
+		if (picked == &camera)
+			camera.MouseDrag((int) x, (int) y, Shift(w));
+        Redraw();
+	}
+}
+
+void MouseWheel(GLFWwindow *w, double ignore, double spin) {
+    camera.MouseWheel(spin > 0, Shift(w));
+    Redraw();
+}
+
+
+
+// application
+
+void Keyboard(GLFWwindow *w, int key, int scancode, int action, int mods) {
+    if (action == GLFW_PRESS && key == 'T')
+        gpuTimer.Report();
+    // up/down arrows: finer/coarser tessellation
+    if (action == GLFW_PRESS && (key == GLFW_KEY_UP || key == GLFW_KEY_DOWN)) {
+        pixelsPerSegment *= key == GLFW_KEY_UP? .5f : 2;
+        pixelsPerSegment = pixelsPerSegment < 1? 1 : pixelsPerSegment > 256? 256 : pixelsPerSegment;
+        float outer[4], inner[2];
+        PatchLevels(ctrlPts, camera.fullview, winWidth, winHeight, pixelsPerSegment, outer, inner);
+        printf("%g pixels/segment: outer levels %g %g %g %g, inner %g %g\n",
+               pixelsPerSegment, outer[0], outer[1], outer[2], outer[3], inner[0], inner[1]);
+        Redraw();
+    }
+}
+
+void Resize(GLFWwindow *window, int width, int height) {
+    winWidth = width;
+    winHeight = height;
+    camera.Resize(width, height);
+    glViewport(0, 0, width, height);
+    Redraw();
+}
+
+// configure default control points
+void DefaultControlPoints() {
+    vec3 p0 = vec3(-.8f, -.8f, 0), p1 = vec3(.8f, -.8f, 0), p2 = vec3(-.8f, .8f, 0), p3 = vec3(.8f, .8f, 0);
+    float vals[] = { 0, 1 / 3.f, 2 / 3.f, 1. };
+    for (int i = 0; i < 16; i++) {
+        float ax = vals[i % 4], ay = vals[i / 4];
+        vec3 p10 = p0 + ax * (p1 - p0), p32 = p2 + ax * (p3 - p2);
+        ctrlPts[i / 4][i % 4] = p10 + ay * (p32 - p10);
+    }
+}
+
+int main(int ac, char **av) {
+    // init app window (offscreen if benchmarking)
+    bool bench = HeadlessArgs(ac, av);
+    GLFWwindow *w = NULL;
+    if (bench) {
+        if (!InitHeadless(winWidth, winHeight))
+            return 1;
+    }
+    else {
+        if (!glfwInit())
+            return 1;
+        w = glfwCreateWindow(winWidth, winHeight, "Bezier Patch w Interactive Points by Edwrd Lam", NULL, NULL);
+        glfwSetWindowPos(w, 100, 100);
+        glfwMakeContextCurrent(w);
+        // init OpenGL
+        gladLoadGLLoader((GLADloadproc) glfwGetProcAddress);
+    }
+    // init shader program, texture (tessellate on the CPU without GL 4.0, or if --cpu)
+    GLint major = 0;
+    glGetIntegerv(GL_MAJOR_VERSION, &major);
+    cpuTessellate = major < 4;
+    for (int i = 1; i < ac; i++)
+        cpuTessellate = cpuTessellate || !strcmp(av[i], "--cpu");
+    if (!cpuTessellate)
+        program = LinkProgramViaCache(&vShaderCode, &tcShaderCode, &teShaderCode, NULL, &pShaderCode);
+    if (!program) {
+        cpuTessellate = true;
+        cpuProgram = LinkProgramViaCache(&cpuVShaderCode, &cpuPShaderCode);
+        CacheLocations(cpuProgram);
+        BindCameraBlock(cpuProgram);
+    }
+    else {
+        CacheLocations(program);
+        BindCameraBlock(program);
+    }
+    DefaultControlPoints();
+    picker.Add(&ctrlPts[0][0], 16);
+    asyncTexture.Load(textureFilename, textureUnit, Redraw);
+    if (bench) {
+        // report GPU times while the context is current (stdout holds the benchmark JSON)
+        return RunHeadless("BezierPatch", Display, &camera, [] { gpuTimer.Report(stderr); });
+    }
+    // callbacks
+    glfwSetCursorPosCallback(w, MouseMove);
+    glfwSetMouseButtonCallback(w, MouseButton);
+    glfwSetScrollCallback(w, MouseWheel);
+    glfwSetWindowSizeCallback(w, Resize);
+    glfwSetKeyCallback(w, Keyboard);
+    printf("Usage: up/down arrows: finer/coarser tessellation, T: GPU times\n");
+    // event loop: draw only after input or resize
+    glfwSwapInterval(1);
+    while (NextFrame(w)) {
+        Display();
+        glfwSwapBuffers(w);
+    }
+    mesh.Release();
+    indices.Release();
+    overlay.Release();
+    ReleaseCameraBlock();
+    gpuTimer.Report();
+    gpuTimer.Release();
+    asyncTexture.Release();
+    glfwDestroyWindow(w);
+    glfwTerminate();
+}
@@ -1,204 +1,261 @@
-// FacetedGouraud.cpp (c) Jules Bloomenthal 2020, all rights reserved
-
-#include <glad.h>
-#include <GLFW/glfw3.h>
-#include <stdio.h>
-#include <vector>
-#include "Camera.h"
-#include "Draw.h"
-#include "GLXtras.h"
-#include "VecMat.h"
-#include "Widgets.h"
-
-// vertex buffer, shader program ids
-GLuint vBuffer = 0, progFaceted = 0;
-
-// display parameters
-int screenWidth = 900, screenHeight = 900;
-Camera camera(screenWidth, screenHeight, vec3(0, 0, 0), vec3(0, 0, -20), 30);
-    // respond to mouse events, half screen size, set back on z-axis, with fov of 30
-
-// interaction
-vec3 light(1.1f, 1.7f, -1.2f);
-Mover lightMover;
-void *picked = NULL;
-
-// Shaders
-
-const char *vertexShader = R"(
-    #version 130
-    in vec3 point;
-    in vec3 color;
-    in vec3 normal;
-    out vec3 vColor;
-    uniform vec3 light;
-    uniform mat4 modelview;
-    uniform mat4 persp;
-    uniform float a = .2;                       // ambient
-    void main() {
-        gl_Position = persp*modelview*vec4(point, 1);
-        vec3 vlight = normalize(light-point);
-        float d = max(0, dot(normal, vlight)); // diffuse
-        float s = pow(d, 50);                  // specular
-        float intensity = clamp(a+d+s, 0, 1);
-        vColor = intensity*color;
-    }
-)";
-
-const char *pixelShader = R"(
-    #version 130
-    in vec3 vColor;
-    out vec4 pColor;
-    void main() {
-        pColor = vec4(vColor, 1);
-    }
-)";
-
-// Mouse
-
-bool Shift(GLFWwindow *w) {
-    return glfwGetKey(w, GLFW_KEY_LEFT_SHIFT) == GLFW_PRESS ||
-           glfwGetKey(w, GLFW_KEY_RIGHT_SHIFT) == GLFW_PRESS;
-}
-
-int WindowHeight(GLFWwindow *w) {
-    int width, height;
-    glfwGetWindowSize(w, &width, &height);
-    return height;
-}
-
-void MouseButton(GLFWwindow *w, int butn, int action, int mods) {
-    double x, y;
-    glfwGetCursorPos(w, &x, &y);
-	y = WindowHeight(w)-y;
-    picked = NULL;
-    if (action == GLFW_PRESS) {
-        if (MouseOver(x, y, light, camera.fullview, 20)) {
-			picked = &lightMover;
-            lightMover.Down(&light, (int) x, (int) y, camera.modelview, camera.persp);
-        }
-        if (picked == NULL) {
-            picked = &camera;
-            camera.MouseDown((int) x, (int) y);
-        }
-    }
-    if (action == GLFW_RELEASE)
-        camera.MouseUp();
-}
-
-void MouseMove(GLFWwindow *w, double x, double y) {
-	y = WindowHeight(w)-y;
-    if (glfwGetMouseButton(w, GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS) {
-        if (picked == &lightMover)
-            lightMover.Drag((int) x, (int) y, camera.modelview, camera.persp);
-        else
-            camera.MouseDrag(x, y, Shift(w));
-    }
-}
-
-void MouseWheel(GLFWwindow *w, double ignore, double spin) {
-    camera.MouseWheel(spin > 0, Shift(w));
-}
-
-// Vertex Buffer
-
-struct Vertex {
-    vec3 point, color, normal;
-    Vertex() { }
-    Vertex(vec3 p, vec3 c, vec3 n) : point(p), color(c), normal(n) { }
-};
-
-// 8 points and 8 colors:
-float l = -1, r = 1, b = -1, t = 1, n = -1, f = 1;
-float points[][3] = {{l, b, n}, {l, b, f}, {l, t, n}, {l, t, f}, {r, b, n}, {r, b, f}, {r, t, n}, {r, t, f}};
-float colors[][3] = {{0, 0, 0}, {0, 0, 1}, {0, 1, 0}, {0, 1, 1}, {1, 0, 0}, {1, 0, 1}, {1, 1, 0}, {1, 1, 1}};
-
-// 6 faces (quads and normals)
-int quads[][4] = {{1, 3, 2, 0}, {6, 7, 5, 4}, {4, 5, 1, 0}, {3, 7, 6, 2}, {2, 6, 4, 0}, {5, 7, 3, 1}};
-vec3 normals[] = {vec3(-1, 0, 0), vec3(1, 0, 0), vec3(0, -1, 0), vec3(0, 1, 0), vec3(0, 0, -1), vec3(0, 0, 1)};
-const int nvertices = sizeof(quads)/sizeof(int), nquads = nvertices/4;
-
-void InitVertexBuffer() {
-    // create interleaved vertices (see ex. 4.5), non-indexed (ie, for use with glDrawArrays)
-    Vertex vertices[nvertices];
-    for (int i = 0; i < nquads; i++) {
-        vec3 n = normals[i];        // use same normal for all 4 face vertices
-        int *f = quads[i];
-        for (int k = 0; k < 4; k++) {
-            int vid = f[k];
-            vertices[4*i+k] = Vertex(vec3(points[vid]), vec3(colors[vid]), n);
-        }
-    }
-    // create and bind GPU vertex buffer, copy vertex data
-    glGenBuffers(1, &vBuffer);
-    glBindBuffer(GL_ARRAY_BUFFER, vBuffer);
-    glBufferData(GL_ARRAY_BUFFER, nvertices*sizeof(Vertex), &vertices[0], GL_STATIC_DRAW);
-}
-
-// Display
-
-void Display(GLFWwindow *w) {
-    // clear screen, enable z-buffer
-    glClearColor(.5, .5, .5, 1);
-    glClear(GL_COLOR_BUFFER_BIT);
-    glClear(GL_DEPTH_BUFFER_BIT);
-    glEnable(GL_DEPTH_TEST);
-	glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-    glUseProgram(progFaceted);
-    glBindBuffer(GL_ARRAY_BUFFER, vBuffer);
-    VertexAttribPointer(progFaceted, "point", 3, sizeof(Vertex), (void *) 0);
-    VertexAttribPointer(progFaceted, "color", 3, sizeof(Vertex), (void *) sizeof(vec3));
-    VertexAttribPointer(progFaceted, "normal", 3, sizeof(Vertex), (void *) (2*sizeof(vec3)));
-    SetUniform(progFaceted, "modelview", camera.modelview);
-    SetUniform(progFaceted, "persp", camera.persp);
-    SetUniform(progFaceted, "light", light);
-    glDrawArrays(GL_QUADS, 0, nvertices);
-    // draw light
-    UseDrawShader(camera.fullview);
-    glDisable(GL_DEPTH_TEST);
-    bool visible = IsVisible(light, camera.fullview);
-    bool incube = fabs(light.x) < 1 && fabs(light.y) < 1 && fabs(light.z) < 1;
-    Disk(light, 12, incube? vec3(0,0,1) : vec3(1,0,0), visible? 1 : .25f);
-    glFlush();
-}
-
-// Application
-
-const char *usage = "Usage\n\
-    mouse-drag:\t\trotate x,y\n\
-    with shift:\t\ttranslate x,y\n\
-    mouse-wheel:\trotate/translate z\n";
-
-void Resize(GLFWwindow *w, int width, int height) {
-    camera.Resize(width, height);
-    glViewport(0, 0, screenWidth = width, screenHeight = height);
-}
-
-int main(int ac, char **av) {
-    // init app window and GL context
-    glfwInit();
-    GLFWwindow *w = glfwCreateWindow(screenWidth, screenHeight, "Shaded, Faceted Cube", NULL, NULL);
-    glfwSetWindowPos(w, 100, 100);
-    glfwMakeContextCurrent(w);
-    gladLoadGLLoader((GLADloadproc) glfwGetProcAddress);
-    // init shader and GPU data
-    progFaceted = LinkProgramViaCode(&vertexShader, &pixelShader);
-    InitVertexBuffer();
-    printf(usage);
-    // callbacks
-    glfwSetCursorPosCallback(w, MouseMove);
-    glfwSetMouseButtonCallback(w, MouseButton);
-    glfwSetScrollCallback(w, MouseWheel);
-    glfwSetWindowSizeCallback(w, Resize);
-    // event loop
-    glfwSwapInterval(1);
-    while (!glfwWindowShouldClose(w)) {
-        glfwPollEvents();
-        Display(w);
-        glfwSwapBuffers(w);
-    }
-    glDeleteBuffers(1, &vBuffer);
-    glfwDestroyWindow(w);
-    glfwTerminate();
-}
+// FacetedGouraud.cpp (c) Jules Bloomenthal 2020, all rights reserved
+
+#include <glad.h>
+#include <GLFW/glfw3.h>
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <vector>
+#include "Camera.h"
+#include "CameraBlock.h"
+#include "Draw.h"
+#include "GLXtras.h"
+#include "Headless.h"
+#include "Mesh.h"
+#include "Redraw.h"
+#include "SoftRaster.h"
+#include "Uniforms.h"
+#include "VecMat.h"
+#include "Widgets.h"
+
+// vertex buffer and layout, shader program id
+Mesh mesh;
+GLuint progFaceted = 0;
+
+// display parameters
+int screenWidth = 900, screenHeight = 900;
+Camera camera(screenWidth, screenHeight, vec3(0, 0, 0), vec3(0, 0, -20), 30);
+    // respond to mouse events, half screen size, set back on z-axis, with fov of 30
+
+// interaction
+vec3 light(1.1f, 1.7f, -1.2f);
+Mover lightMover;
+void *picked = NULL;
+
+// Shaders
+
+const char *vertexShader = R"(
+    #version 140
+    in vec3 point;
+    in vec3 color;
+    in vec3 normal;
+    out vec3 vColor;
+    uniform vec3 light;
+    layout (std140, row_major) uniform Camera { mat4 modelview, persp, fullview; };
+    uniform float a = .2;                       // ambient
+    void main() {
+        gl_Position = persp*modelview*vec4(point, 1);
+        vec3 vlight = normalize(light-point);
+        float d = max(0, dot(normal, vlight)); // diffuse
+        float s = pow(d, 50);                  // specular
+        float intensity = clamp(a+d+s, 0, 1);
+        vColor = intensity*color;
+    }
+)";
+
+const char *pixelShader = R"(
+    #version 130
+    in vec3 vColor;
+    out vec4 pColor;
+    void main() {
+        pColor = vec4(vColor, 1);
+    }
+)";
+
+// Mouse
+
+bool Shift(GLFWwindow *w) {
+    return glfwGetKey(w, GLFW_KEY_LEFT_SHIFT) == GLFW_PRESS ||
+           glfwGetKey(w, GLFW_KEY_RIGHT_SHIFT) == GLFW_PRESS;
+}
+
+int WindowHeight(GLFWwindow *w) {
+    int width, height;
+    glfwGetWindowSize(w, &width, &height);
+    return height;
+}
+
+void MouseButton(GLFWwindow *w, int butn, int action, int mods) {
+    double x, y;
+    glfwGetCursorPos(w, &x, &y);
+	y = WindowHeight(w)-y;
+    picked = NULL;
+    if (action == GLFW_PRESS) {
+        if (MouseOver(x, y, light, camera.fullview, 20)) {
+			picked = &lightMover;
+            lightMover.Down(&light, (int) x, (int) y, camera.modelview, camera.persp);
+        }
+        if (picked == NULL) {
+            picked = &camera;
+            camera.MouseDown((int) x, (int) y);
+        }
+    }
+    if (action == GLFW_RELEASE)
+        camera.MouseUp();
+    Redraw();
+}
+
+void MouseMove(GLFWwindow *w, double x, double y) {
+	y = WindowHeight(w)-y;
+    if (glfwGetMouseButton(w, GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS) {
+        if (picked == &lightMover)
+            lightMover.Drag((int) x, (int) y, camera.modelview, camera.persp);
+        else
+            camera.MouseDrag(x, y, Shift(w));
+        Redraw();
+    }
+}
+
+void MouseWheel(GLFWwindow *w, double ignore, double spin) {
+    camera.MouseWheel(spin > 0, Shift(w));
+    Redraw();
+}
+
+// Vertex Buffer
+
+struct Vertex {
+    vec3 point, color, normal;
+    Vertex() { }
+    Vertex(vec3 p, vec3 c, vec3 n) : point(p), color(c), normal(n) { }
+};
+
+// 8 points and 8 colors:
+float l = -1, r = 1, b = -1, t = 1, n = -1, f = 1;
+float points[][3] = {{l, b, n}, {l, b, f}, {l, t, n}, {l, t, f}, {r, b, n}, {r, b, f}, {r, t, n}, {r, t, f}};
+float colors[][3] = {{0, 0, 0}, {0, 0, 1}, {0, 1, 0}, {0, 1, 1}, {1, 0, 0}, {1, 0, 1}, {1, 1, 0}, {1, 1, 1}};
+
+// 6 faces (quads and normals)
+int quads[][4] = {{1, 3, 2, 0}, {6, 7, 5, 4}, {4, 5, 1, 0}, {3, 7, 6, 2}, {2, 6, 4, 0}, {5, 7, 3, 1}};
+vec3 normals[] = {vec3(-1, 0, 0), vec3(1, 0, 0), vec3(0, -1, 0), vec3(0, 1, 0), vec3(0, 0, -1), vec3(0, 0, 1)};
+const int nvertices = sizeof(quads)/sizeof(int), nquads = nvertices/4;
+
+void InitVertexBuffer() {
+    // create interleaved vertices (see ex. 4.5), non-indexed (ie, for use with glDrawArrays)
+    Vertex vertices[nvertices];
+    for (int i = 0; i < nquads; i++) {
+        vec3 n = normals[i];        // use same normal for all 4 face vertices
+        int *f = quads[i];
+        for (int k = 0; k < 4; k++) {
+            int vid = f[k];
+            vertices[4*i+k] = Vertex(vec3(points[vid]), vec3(colors[vid]), n);
+        }
+    }
+    // create GPU vertex buffer, copy vertex data
+    mesh.Allocate(nvertices*sizeof(Vertex), &vertices[0]);
+    // record interleaved vertex feed once, in the mesh's vertex array object
+    mesh.Attribute(progFaceted, "point", 3, sizeof(Vertex), 0);
+    mesh.Attribute(progFaceted, "color", 3, sizeof(Vertex), sizeof(vec3));
+    mesh.Attribute(progFaceted, "normal", 3, sizeof(Vertex), 2*sizeof(vec3));
+}
+
+// Display
+
+void Display(GLFWwindow *w) {
+    // clear screen, enable z-buffer
+    glClearColor(.5, .5, .5, 1);
+    glClear(GL_COLOR_BUFFER_BIT);
+    glClear(GL_DEPTH_BUFFER_BIT);
+    glEnable(GL_DEPTH_TEST);
+	glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glUseProgram(progFaceted);
+    mesh.Bind();
+    UpdateCameraBlock(camera);          // sends matrices only if the camera changed
+    SetUniform(UniformLocation(progFaceted, "light"), light);
+    glDrawArrays(GL_QUADS, 0, nvertices);
+    mesh.Unbind();
+    // draw light
+    UseDrawShader(camera.fullview);
+    glDisable(GL_DEPTH_TEST);
+    bool visible = IsVisible(light, camera.fullview);
+    bool incube = fabs(light.x) < 1 && fabs(light.y) < 1 && fabs(light.z) < 1;
+    Disk(light, 12, incube? vec3(0,0,1) : vec3(1,0,0), visible? 1 : .25f);
+    glFlush();
+}
+
+// Application
+
+const char *usage = "Usage\n\
+    mouse-drag:\t\trotate x,y\n\
+    with shift:\t\ttranslate x,y\n\
+    mouse-wheel:\trotate/translate z\n";
+
+void Resize(GLFWwindow *w, int width, int height) {
+    camera.Resize(width, height);
+    glViewport(0, 0, screenWidth = width, screenHeight = height);
+    Redraw();
+}
+
+// Software Rendering
+
+int RenderSoft(const char *filename, int ac, char **av) {
+    // the shaders above, on the CPU (without the light's disk); options as RenderSoftFrames()
+    // each quad as two triangles, vertices in the order of InitVertexBuffer
+    int triangles[2*nquads][3];
+    for (int i = 0; i < nquads; i++) {
+        int t[2][3] = {{4*i, 4*i+1, 4*i+2}, {4*i, 4*i+2, 4*i+3}};
+        memcpy(triangles[2*i], t, sizeof(t));
+    }
+    mat4 modelview, persp;
+    // vertex shader: varying vColor (0-2)
+    auto vertex = [&](int i, float *v) {
+        vec3 point(points[quads[i/4][i%4]]), color(colors[quads[i/4][i%4]]), normal = normals[i/4];
+        vec3 vlight = normalize(light-point);
+        float d = std::max(0.f, dot(normal, vlight)), s = pow(d, 50.f);
+        float intensity = std::min(1.f, .2f+d+s);
+        v[0] = intensity*color.x; v[1] = intensity*color.y; v[2] = intensity*color.z;
+        return persp*modelview*vec4(point.x, point.y, point.z, 1);
+    };
+    // pixel shader
+    auto pixel = [](const float *v) { return vec3(v[0], v[1], v[2]); };
+    return RenderSoftFrames(filename, ac, av, [&](SoftRaster &raster) {
+        camera.Resize(raster.Width(), raster.Height());
+        modelview = camera.modelview;
+        persp = camera.persp;
+        raster.Draw(nvertices, triangles[0], 2*nquads, 3, vertex, pixel);
+    });
+}
+
+int main(int ac, char **av) {
+    // or render on the CPU, without GL: --soft file.ppm [--size WxH] [--frames n] [--threads n]
+    for (int i = 1; i < ac; i++)
+        if (!strcmp(av[i], "--soft") && i+1 < ac)
+            return RenderSoft(av[i+1], ac, av);
+    // init app window and GL context (offscreen if benchmarking)
+    bool bench = HeadlessArgs(ac, av);
+    GLFWwindow *w = NULL;
+    if (bench) {
+        if (!InitHeadless(screenWidth, screenHeight))
+            return 1;
+    }
+    else {
+        glfwInit();
+        w = glfwCreateWindow(screenWidth, screenHeight, "Shaded, Faceted Cube", NULL, NULL);
+        glfwSetWindowPos(w, 100, 100);
+        glfwMakeContextCurrent(w);
+        gladLoadGLLoader((GLADloadproc) glfwGetProcAddress);
+    }
+    // init shader and GPU data
+    progFaceted = LinkProgramViaCode(&vertexShader, &pixelShader);
+    CacheLocations(progFaceted);
+    BindCameraBlock(progFaceted);
+    InitVertexBuffer();
+    if (bench)
+        return RunHeadless("FacetedCube", [] { Display(NULL); }, &camera);
+    printf(usage);
+    // callbacks
+    glfwSetCursorPosCallback(w, MouseMove);
+    glfwSetMouseButtonCallback(w, MouseButton);
+    glfwSetScrollCallback(w, MouseWheel);
+    glfwSetWindowSizeCallback(w, Resize);
+    // event loop: draw only after input or resize
+    glfwSwapInterval(1);
+    while (NextFrame(w)) {
+        Display(w);
+        glfwSwapBuffers(w);
+    }
+    mesh.Release();
+    ReleaseCameraBlock();
+    glfwDestroyWindow(w);
+    glfwTerminate();
+}
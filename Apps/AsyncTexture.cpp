@@ -0,0 +1,259 @@
+// AsyncTexture.cpp - texture read on a worker thread, shown once it has arrived
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "AsyncTexture.h"
+
+using std::vector;
+
+// TGA
+
+struct TgaInfo {
+    int type = 0;                               // 2: uncompressed, 10: run-length encoded
+    int width = 0, height = 0, channels = 0;    // channels 3 (BGR) or 4 (BGRA)
+    bool topDown = false;                       // first row in the file is the top row
+};
+
+static const char *ReadTgaHeader(FILE *in, TgaInfo &t) {
+    uint8_t h[18];
+    if (fread(h, 1, 18, in) != 18)
+        return "too short for a TGA header";
+    t.type = h[2];
+    t.width = h[12] | h[13] << 8;
+    t.height = h[14] | h[15] << 8;
+    t.channels = h[16]/8;
+    t.topDown = (h[17] & 0x20) != 0;
+    if (h[1] != 0 || (t.type != 2 && t.type != 10))
+        return "not a true-color TGA";
+    if (t.channels != 3 && t.channels != 4)
+        return "not 24 or 32 bits per pixel";
+    if (!t.width || !t.height)
+        return "empty image";
+    if (fseek(in, h[0], SEEK_CUR))              // skip image id
+        return "truncated";
+    return NULL;
+}
+
+static const char *ReadTgaPixels(FILE *in, const TgaInfo &t, uint8_t *pixels, const std::atomic<bool> &cancel) {
+    // pixels: width*height*channels bytes, bottom row first (as GL), BGR(A) as in the file;
+    // stop early if cancel is set
+    size_t rowBytes = (size_t) t.width*t.channels;
+    auto Row = [&](int fileRow) { return pixels+rowBytes*(t.topDown? t.height-1-fileRow : fileRow); };
+    if (t.type == 2) {
+        for (int r = 0; r < t.height; r++) {
+            if (cancel)
+                return "cancelled";
+            if (fread(Row(r), 1, rowBytes, in) != rowBytes)
+                return "truncated";
+        }
+        return NULL;
+    }
+    // run-length packets may cross rows: decode by pixel index
+    long start = ftell(in);
+    fseek(in, 0, SEEK_END);
+    vector<uint8_t> data((size_t) (ftell(in)-start));
+    fseek(in, start, SEEK_SET);
+    if (fread(data.data(), 1, data.size(), in) != data.size())
+        return "truncated";
+    const uint8_t *s = data.data(), *end = s+data.size();
+    int c = t.channels, row = 0, col = 0;
+    uint8_t *dst = Row(0);
+    while (row < t.height) {
+        if (s >= end)
+            return "truncated";
+        int packet = *s++, count = (packet & 0x7f)+1;
+        bool run = (packet & 0x80) != 0;
+        if (end-s < (run? c : count*c))
+            return "truncated";
+        for (int k = 0; k < count && row < t.height; k++) {
+            memcpy(dst+col*c, s, c);
+            if (!run)
+                s += c;
+            if (++col == t.width) {
+                col = 0;
+                if (++row < t.height)
+                    dst = Row(row);
+                if (cancel)
+                    return "cancelled";
+            }
+        }
+        if (run)
+            s += c;
+    }
+    return NULL;
+}
+
+// mipmaps
+
+static void Halve(const vector<uint8_t> &src, int w, int h, int c, vector<uint8_t> &dst) {
+    // 2x2 box filter; an odd last row or column is dropped
+    int dw = w > 1? w/2 : 1, dh = h > 1? h/2 : 1;
+    dst.resize((size_t) dw*dh*c);
+    for (int y = 0; y < dh; y++) {
+        const uint8_t *r0 = &src[(size_t) (2*y < h? 2*y : h-1)*w*c];
+        const uint8_t *r1 = &src[(size_t) (2*y+1 < h? 2*y+1 : h-1)*w*c];
+        uint8_t *d = &dst[(size_t) y*dw*c];
+        for (int x = 0; x < dw; x++) {
+            int x0 = 2*x < w? 2*x : w-1, x1 = 2*x+1 < w? 2*x+1 : w-1;
+            for (int k = 0; k < c; k++)
+                *d++ = (uint8_t) ((r0[x0*c+k]+r0[x1*c+k]+r1[x0*c+k]+r1[x1*c+k]+2) >> 2);
+        }
+    }
+}
+
+// worker
+
+void AsyncTexture::Read() {
+    TgaInfo t;
+    FILE *in = fopen(filename.c_str(), "rb");
+    const char *err = in? ReadTgaHeader(in, t) : "can't open";
+    if (!err) {
+        channels = t.channels;
+        levels.push_back({t.width, t.height, vector<uint8_t>((size_t) t.width*t.height*t.channels)});
+        err = ReadTgaPixels(in, t, levels[0].pixels.data(), cancel);
+    }
+    if (in)
+        fclose(in);
+    // mipmaps down to 1x1
+    while (!err && (levels.back().width > 1 || levels.back().height > 1)) {
+        if (cancel) {
+            err = "cancelled";
+            break;
+        }
+        const Level &l = levels.back();
+        Level half;
+        Halve(l.pixels, l.width, l.height, channels, half.pixels);
+        half.width = l.width > 1? l.width/2 : 1;
+        half.height = l.height > 1? l.height/2 : 1;
+        levels.push_back(std::move(half));
+    }
+    if (err)
+        error = err;
+    state = err? Failed : Decoded;
+    if (wake)
+        wake();
+}
+
+void AsyncTexture::Join() {
+    cancel = true;
+    if (worker.joinable())
+        worker.join();
+    cancel = false;
+}
+
+// GL thread
+
+GLuint AsyncTexture::Load(const char *name, int textureUnit, void (*wakeFunction)()) {
+    Release();
+    filename = name;
+    unit = textureUnit;
+    wake = wakeFunction;
+    error.clear();
+    // 1x1 mid-gray placeholder, so shading reads as untextured until the image arrives
+    uint8_t gray[4] = {128, 128, 128, 255};
+    glGenTextures(1, &texture);
+    glActiveTexture(GL_TEXTURE0+unit);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, gray);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    state = Reading;
+    worker = std::thread(&AsyncTexture::Read, this);
+    return texture;
+}
+
+GLuint AsyncTexture::Update(int budget) {
+    int s = state;
+    if (s == Failed && worker.joinable()) {
+        worker.join();
+        levels.clear();
+        printf("can't read %s: %s (using placeholder)\n", filename.c_str(), error.c_str());
+    }
+    if (s == Decoded) {
+        // storage for every level of a second texture, filled over the next frames
+        worker.join();
+        int nLevels = (int) levels.size();
+        GLenum format = channels == 4? GL_BGRA : GL_BGR;
+        glGenTextures(1, &pending);
+        glActiveTexture(GL_TEXTURE0+unit);
+        glBindTexture(GL_TEXTURE_2D, pending);
+        GLenum internal = channels == 4? GL_RGBA8 : GL_RGB8;
+        if (glTexStorage2D)                     // GL 4.2: immutable, allocated at once
+            glTexStorage2D(GL_TEXTURE_2D, nLevels, internal, levels[0].width, levels[0].height);
+        else
+            for (int i = 0; i < nLevels; i++)
+                glTexImage2D(GL_TEXTURE_2D, i, internal, levels[i].width, levels[i].height, 0, format, GL_UNSIGNED_BYTE, NULL);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, nLevels-1);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glGenBuffers(1, &pbo);
+        level = row = 0;
+        state = s = Uploading;
+    }
+    if (s == Uploading) {
+        GLenum format = channels == 4? GL_BGRA : GL_BGR;
+        glActiveTexture(GL_TEXTURE0+unit);
+        glBindTexture(GL_TEXTURE_2D, pending);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo);
+        GLint alignment = 4;
+        glGetIntegerv(GL_UNPACK_ALIGNMENT, &alignment);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);  // rows are not padded
+        for (int sent = 0; sent < budget && level < (int) levels.size(); ) {
+            Level &l = levels[level];
+            int rowBytes = l.width*channels, n = (budget-sent)/rowBytes;
+            n = n < 1? 1 : n > l.height-row? l.height-row : n;
+            GLsizeiptr bytes = (GLsizeiptr) n*rowBytes;
+            // orphan the previous strip's storage, so the copy need not wait for the GPU
+            glBufferData(GL_PIXEL_UNPACK_BUFFER, bytes, NULL, GL_STREAM_DRAW);
+            void *p = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, bytes, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+            const uint8_t *strip = &l.pixels[(size_t) row*rowBytes];
+            if (p)
+                memcpy(p, strip, bytes);
+            if (p && glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER))
+                glTexSubImage2D(GL_TEXTURE_2D, level, 0, row, l.width, n, format, GL_UNSIGNED_BYTE, NULL);
+            else {
+                // no mapping, or its contents were lost: copy from memory
+                glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+                glTexSubImage2D(GL_TEXTURE_2D, level, 0, row, l.width, n, format, GL_UNSIGNED_BYTE, strip);
+                glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo);
+            }
+            sent += (int) bytes;
+            if ((row += n) == l.height) {
+                vector<uint8_t>().swap(l.pixels);
+                level++;
+                row = 0;
+            }
+        }
+        glPixelStorei(GL_UNPACK_ALIGNMENT, alignment);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        if (level < (int) levels.size()) {
+            if (wake)
+                wake();                         // more strips next frame
+        }
+        else {
+            // complete: replace the placeholder
+            glDeleteBuffers(1, &pbo);
+            glDeleteTextures(1, &texture);
+            texture = pending;
+            pbo = pending = 0;
+            levels.clear();
+            state = Done;
+        }
+    }
+    return texture;
+}
+
+void AsyncTexture::Release() {
+    Join();
+    if (pbo)
+        glDeleteBuffers(1, &pbo);
+    if (pending)
+        glDeleteTextures(1, &pending);
+    if (texture)
+        glDeleteTextures(1, &texture);
+    texture = pending = pbo = 0;
+    levels.clear();
+    channels = 0;
+    state = Idle;
+}
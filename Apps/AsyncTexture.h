@@ -0,0 +1,65 @@
+// AsyncTexture.h - texture read on a worker thread, shown once it has arrived
+//
+// LoadTexture() reads and decodes the image before returning, so main() waits on it
+// and, for large images, the first frame is late by seconds; here Load() returns at
+// once with a gray placeholder texture, while a worker thread decodes the TGA and
+// builds its mipmaps (2x2 box filter); Update(), called each frame, then streams a
+// bounded number of bytes per frame, strip by strip, through a pixel buffer object
+// into a second texture, which replaces the placeholder when every level is in, so no
+// one frame pays for the whole upload (an 8k image is ~250MB with mipmaps); the worker,
+// and Update() while streaming, call a wake function (eg, Redraw) so an event-driven
+// loop keeps drawing until the image is in place
+//
+// usage:
+//     AsyncTexture asyncTexture;
+//     asyncTexture.Load(textureFilename, textureUnit, Redraw);
+//     void Display() { textureName = asyncTexture.Update(); ...bind textureName, draw... }
+//     asyncTexture.Release();                     // on exit, context still current
+
+#ifndef ASYNC_TEXTURE_HDR
+#define ASYNC_TEXTURE_HDR
+
+#include <glad.h>
+#include <stdint.h>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+class AsyncTexture {
+public:
+    GLuint Load(const char *filename, int textureUnit = 0, void (*wake)() = NULL);
+        // return placeholder texture, bound to textureUnit, and start reading filename
+        // (uncompressed or run-length encoded TGA, 24 or 32 bits) on a worker thread
+    GLuint Update(int budget = 8 << 20);
+        // on the GL thread, before drawing: upload up to budget bytes of decoded image;
+        // return the texture to draw with (the placeholder until the image is complete);
+        // if the image can't be read, print why and keep the placeholder
+    bool Ready() const { return state == Done; }
+    GLuint Name() const { return texture; }
+    void Release();
+        // wait for the worker, delete textures and buffer
+    AsyncTexture() { }
+    AsyncTexture(const AsyncTexture &) = delete;
+    AsyncTexture &operator=(const AsyncTexture &) = delete;
+    ~AsyncTexture() { Join(); }
+private:
+    enum { Idle, Reading, Decoded, Uploading, Done, Failed };
+    struct Level {
+        int width, height;
+        std::vector<uint8_t> pixels;            // bottom row first, BGR(A) as in the file
+    };
+    std::atomic<int> state{Idle};
+    std::atomic<bool> cancel{false};
+    std::thread worker;
+    std::vector<Level> levels;                  // written by the worker until Decoded
+    int channels = 0, level = 0, row = 0;       // next strip to upload
+    GLuint texture = 0, pending = 0, pbo = 0;   // shown, being filled, staging
+    int unit = 0;
+    std::string filename, error;
+    void (*wake)() = NULL;
+    void Read();
+    void Join();
+};
+
+#endif
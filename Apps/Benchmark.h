@@ -0,0 +1,40 @@
+// Benchmark.h - timing and repeatable random data for the module benchmarks
+//
+// BenchmarkNormals(), BenchmarkVecBatch() and BenchmarkBvh() each time a few
+// alternatives over the same inputs; the fastest of several runs is reported (the
+// others are slowed by caches warming and by other processes), and inputs come
+// from a fixed-seed generator so results compare across runs and machines
+//
+// usage:
+//     Random random;                                  // same sequence every run
+//     for (...) p = vec3(random(), random(), random());   // each in [-1, 1)
+//     float ms = MinTime(20, [&]() { ... });          // fastest of 20 runs
+
+#ifndef BENCHMARK_HDR
+#define BENCHMARK_HDR
+
+#include <stdint.h>
+#include <chrono>
+
+template<typename F> float MinTime(int nRuns, F f) {
+    // fastest of nRuns calls to f, in milliseconds
+    float best = 1e30f;
+    for (int i = 0; i < nRuns; i++) {
+        auto start = std::chrono::steady_clock::now();
+        f();
+        float ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now()-start).count();
+        best = ms < best? ms : best;
+    }
+    return best;
+}
+
+class Random {
+public:
+    Random(uint32_t seed = 1) : seed(seed) { }
+    float operator()() { seed = seed*1664525u+1013904223u; return (float) (seed >> 8)/(1 << 23)-1; }
+        // next value in [-1, 1), from a linear congruential generator
+private:
+    uint32_t seed;
+};
+
+#endif
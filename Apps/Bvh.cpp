@@ -0,0 +1,235 @@
+// Bvh.cpp - bounding volume hierarchy over object boxes, for view frustum culling
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include "Benchmark.h"
+#include "Bvh.h"
+
+void Bounds::Add(const Bounds &b) {
+    for (int k = 0; k < 3; k++) {
+        lo[k] = std::min(lo[k], b.lo[k]);
+        hi[k] = std::max(hi[k], b.hi[k]);
+    }
+}
+
+Bounds Transform(const mat4 &m, const Bounds &b) {
+    // transformed center, plus half-extents through the matrix's absolute values
+    Bounds r;
+    for (int i = 0; i < 3; i++) {
+        float c = m[i][3], e = 0;
+        for (int k = 0; k < 3; k++) {
+            c += m[i][k]*.5f*(b.lo[k]+b.hi[k]);
+            e += fabsf(m[i][k])*.5f*(b.hi[k]-b.lo[k]);
+        }
+        r.lo[i] = c-e;
+        r.hi[i] = c+e;
+    }
+    return r;
+}
+
+// building
+
+void Bvh::Build(const Bounds *b, int n) {
+    boxes.assign(b, b+n);
+    order.resize(n);
+    leafOf.resize(n);
+    for (int i = 0; i < n; i++)
+        order[i] = i;
+    nodes.clear();
+    nodes.reserve(n > 0? 2*((n+leafSize-1)/leafSize) : 0);
+    if (n)
+        Split(0, n, -1);
+}
+
+int Bvh::Split(int first, int count, int parent) {
+    int id = (int) nodes.size();
+    nodes.push_back({Bounds(), first, count, -1, parent});
+    Bounds box, centers;
+    for (int i = first; i < first+count; i++) {
+        const Bounds &b = boxes[order[i]];
+        box.Add(b);
+        vec3 c = .5f*(b.lo+b.hi);
+        centers.Add(Bounds(c, c));
+    }
+    nodes[id].box = box;
+    if (count <= leafSize) {
+        for (int i = first; i < first+count; i++)
+            leafOf[order[i]] = id;
+        return id;
+    }
+    // median of the centers along their longest extent
+    vec3 extent = centers.hi-centers.lo;
+    int axis = extent.x > extent.y? (extent.x > extent.z? 0 : 2) : (extent.y > extent.z? 1 : 2);
+    int half = count/2;
+    std::nth_element(order.begin()+first, order.begin()+first+half, order.begin()+first+count, [this, axis](int a, int b) {
+        return boxes[a].lo[axis]+boxes[a].hi[axis] < boxes[b].lo[axis]+boxes[b].hi[axis];
+    });
+    Split(first, half, id);
+    int right = Split(first+half, count-half, id);
+    nodes[id].right = right;                // after the recursion, as push_back may move nodes
+    return id;
+}
+
+// refitting
+
+bool Bvh::Rebound(int id) {
+    // recompute node's box from its children (or objects); return true if it changed
+    Node &n = nodes[id];
+    Bounds box;
+    if (n.right < 0)
+        for (int i = n.first; i < n.first+n.count; i++)
+            box.Add(boxes[order[i]]);
+    else {
+        box = nodes[id+1].box;
+        box.Add(nodes[n.right].box);
+    }
+    if (!memcmp(&box, &n.box, sizeof(Bounds)))
+        return false;
+    n.box = box;
+    return true;
+}
+
+void Bvh::Update(int object, const Bounds &box) {
+    boxes[object] = box;
+    for (int id = leafOf[object]; id >= 0 && Rebound(id); id = nodes[id].parent)
+        ;
+}
+
+void Bvh::Refit(const Bounds *b) {
+    boxes.assign(b, b+boxes.size());
+    // children follow their parent, so reverse order visits children first
+    for (int id = (int) nodes.size()-1; id >= 0; id--)
+        Rebound(id);
+}
+
+// culling
+
+static float PlaneDistance(const vec4 &p, const Bounds &b, bool far) {
+    // signed distance (times |p.xyz|) of the box corner farthest along (or, if !far, against) p
+    float d = p.w;
+    for (int k = 0; k < 3; k++)
+        d += p[k]*((p[k] > 0) == far? b.hi[k] : b.lo[k]);
+    return d;
+}
+
+void Bvh::Accept(int id, std::vector<int> &visible) {
+    // whole subtree in view: its objects are consecutive in order
+    const Node &n = nodes[id];
+    visible.insert(visible.end(), order.begin()+n.first, order.begin()+n.first+n.count);
+}
+
+int Bvh::Cull(const mat4 &m, std::vector<int> &visible) {
+    // frustum planes of clip space (-w <= x, y, z <= w) in world space: row3 +/- row i
+    vec4 planes[6];
+    for (int i = 0; i < 3; i++) {
+        planes[2*i] = m[3]+m[i];
+        planes[2*i+1] = m[3]-m[i];
+    }
+    visible.clear();
+    stats = Stats();
+    if (nodes.empty())
+        return 0;
+    // each stack entry carries the planes its ancestors straddled; the others need no test
+    struct Entry { int node, planes; };
+    Entry stack[64];
+    int nStack = 0;
+    stack[nStack++] = {0, 0x3f};
+    while (nStack) {
+        Entry e = stack[--nStack];
+        const Node &n = nodes[e.node];
+        stats.nodesTested++;
+        int straddle = 0;
+        bool outside = false;
+        for (int p = 0; p < 6 && !outside; p++)
+            if (e.planes & (1 << p)) {
+                if (PlaneDistance(planes[p], n.box, true) < 0)
+                    outside = true;
+                else if (PlaneDistance(planes[p], n.box, false) < 0)
+                    straddle |= 1 << p;
+            }
+        if (outside)
+            continue;
+        if (!straddle)
+            Accept(e.node, visible);
+        else if (n.right >= 0) {
+            stack[nStack++] = {n.right, straddle};
+            stack[nStack++] = {e.node+1, straddle};
+        }
+        else
+            // leaf across the boundary: test its objects
+            for (int i = n.first; i < n.first+n.count; i++) {
+                int o = order[i];
+                stats.objectsTested++;
+                bool in = true;
+                for (int p = 0; p < 6 && in; p++)
+                    in = !(straddle & (1 << p)) || PlaneDistance(planes[p], boxes[o], true) >= 0;
+                if (in)
+                    visible.push_back(o);
+            }
+    }
+    stats.visible = (int) visible.size();
+    stats.culled = Count()-stats.visible;
+    return stats.visible;
+}
+
+// benchmark
+
+void BenchmarkBvh(int n, int nRuns) {
+    // n boxes, .5 to 2 across, scattered in +/-100; one in a hundred moves per update
+    Random random;
+    auto RandomBox = [&]() {
+        vec3 c(100*random(), 100*random(), 100*random());
+        float s = .25f+.375f*(random()+1);
+        return Bounds(c-vec3(s, s, s), c+vec3(s, s, s));
+    };
+    std::vector<Bounds> boxes(n), moved(n);
+    for (int i = 0; i < n; i++)
+        boxes[i] = RandomBox();
+    Bvh bvh;
+    float build = MinTime(nRuns, [&]() { bvh.Build(boxes.data(), n); });
+    int nMoved = std::max(1, n/100);
+    for (int i = 0; i < nMoved; i++)
+        moved[i] = RandomBox();
+    int run = 0;
+    float update = MinTime(nRuns, [&]() {
+        // alternately to the new boxes and back, so every run moves them
+        bool back = run++%2 == 1;
+        for (int i = 0; i < nMoved; i++)
+            bvh.Update(i*(n/nMoved), back? boxes[i*(n/nMoved)] : moved[i]);
+    });
+    float refit = MinTime(nRuns, [&]() { bvh.Refit(boxes.data()); });
+    // views from outside the cloud toward its center, wide and narrow
+    printf("{\n  \"n\": %d,\n  \"nodes\": %d,\n  \"build_ms\": %.3f,\n", n, bvh.NNodes(), build);
+    printf("  \"update_ms\": %.3f,\n  \"updated\": %d,\n  \"refit_ms\": %.3f,\n", update, nMoved, refit);
+    float fovs[] = {60, 15};
+    for (int v = 0; v < 2; v++) {
+        mat4 fullview = Perspective(fovs[v], 16.f/9.f, 1, 1000)*Translate(0, 0, -250)*RotateY(30)*RotateX(20);
+        std::vector<int> visible, brute;
+        float cull = MinTime(nRuns, [&]() { bvh.Cull(fullview, visible); });
+        float each = MinTime(nRuns, [&]() {
+            // every box against every plane
+            brute.clear();
+            for (int i = 0; i < n; i++) {
+                bool in = true;
+                for (int p = 0; p < 6 && in; p++) {
+                    vec4 plane = p&1? fullview[3]-fullview[p/2] : fullview[3]+fullview[p/2];
+                    float d = plane.w;
+                    for (int k = 0; k < 3; k++)
+                        d += plane[k]*(plane[k] > 0? boxes[i].hi[k] : boxes[i].lo[k]);
+                    in = d >= 0;
+                }
+                if (in)
+                    brute.push_back(i);
+            }
+        });
+        std::sort(visible.begin(), visible.end());
+        const Bvh::Stats &s = bvh.stats;
+        printf("  \"fov_%d\": {\"visible\": %d, \"culled\": %d, \"nodes_tested\": %d, \"objects_tested\": %d, "
+               "\"cull_ms\": %.3f, \"each_ms\": %.3f, \"speedup\": %.2f, \"match\": %s}%s\n",
+               (int) fovs[v], s.visible, s.culled, s.nodesTested, s.objectsTested, cull, each, each/cull,
+               visible == brute? "true" : "false", v? "" : ",");
+    }
+    printf("}\n");
+}
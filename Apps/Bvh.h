@@ -0,0 +1,80 @@
+// Bvh.h - bounding volume hierarchy over object boxes, for view frustum culling
+//
+// drawing every object whether or not the camera can see it costs a draw (or an instance)
+// per object; here the objects' world-space boxes are held in a binary tree, each node
+// bounding its subtree's objects, and Cull() walks it against the six planes of
+// camera.fullview: a node outside a plane is skipped with all it holds, a node inside
+// all planes is accepted whole, and only nodes straddling the frustum are opened, so the
+// cost follows the number of visible objects and the frustum's boundary, not the total
+//
+// objects that move are updated in place: Update() re-bounds the object's leaf and its
+// ancestors (stopping where a box no longer changes), O(depth) per object, leaving the
+// tree's shape as built; after objects have moved far from where they were built, the
+// boxes grow loose (more nodes straddle) and a fresh Build() restores tight ones
+//
+// usage:
+//     bvh.Build(boxes.data(), boxes.size());
+//     ...
+//     bvh.Update(i, newBox);                      // object i moved
+//     bvh.Cull(camera.fullview, visible);         // ids of objects in view
+//     printf("%i of %i culled\n", bvh.stats.culled, bvh.Count());
+
+#ifndef BVH_HDR
+#define BVH_HDR
+
+#include <float.h>
+#include <vector>
+#include "VecMat.h"
+
+struct Bounds {
+    vec3 lo, hi;
+    Bounds() : lo(FLT_MAX, FLT_MAX, FLT_MAX), hi(-FLT_MAX, -FLT_MAX, -FLT_MAX) { }
+        // empty
+    Bounds(vec3 lo, vec3 hi) : lo(lo), hi(hi) { }
+    void Add(const Bounds &b);
+        // grow to enclose b
+};
+
+Bounds Transform(const mat4 &m, const Bounds &b);
+    // box enclosing b transformed by m (affine)
+
+class Bvh {
+public:
+    static const int leafSize = 4;
+    struct Stats {
+        int nodesTested = 0;            // node boxes tested against the frustum
+        int objectsTested = 0;          // object boxes tested (in leaves that straddle)
+        int visible = 0, culled = 0;
+    };
+    Stats stats;                        // of the last Cull()
+    int Count() const { return (int) boxes.size(); }
+    int NNodes() const { return (int) nodes.size(); }
+    void Build(const Bounds *boxes, int n);
+        // top-down, splitting each node's objects at the median of its longest axis
+    void Update(int object, const Bounds &box);
+        // object moved: set its box and refit the nodes above it
+    void Refit(const Bounds *boxes);
+        // all objects moved: set every box and refit the whole tree bottom-up, O(n)
+    int Cull(const mat4 &fullview, std::vector<int> &visible);
+        // set visible to the ids of objects whose boxes intersect the view frustum,
+        // in tree order; return their number
+private:
+    struct Node {
+        Bounds box;
+        int first, count;               // objects order[first, first+count) lie in this subtree
+        int right;                      // second child (first child is the next node), -1 if a leaf
+        int parent;
+    };
+    std::vector<Node> nodes;            // depth-first: a subtree occupies consecutive nodes
+    std::vector<Bounds> boxes;          // per object
+    std::vector<int> order;             // object ids, grouped by leaf
+    std::vector<int> leafOf;            // per object: its leaf node
+    int Split(int first, int count, int parent);
+    bool Rebound(int node);
+    void Accept(int node, std::vector<int> &visible);
+};
+
+void BenchmarkBvh(int n = 100000, int nRuns = 20);
+    // time build, update, refit and culling of n random boxes against testing each box, print JSON
+
+#endif
@@ -0,0 +1,45 @@
+// CameraBlock.cpp - camera matrices in one uniform buffer, shared by every program
+
+#include <string.h>
+#include "CameraBlock.h"
+
+const GLuint cameraBlockBinding = 0;
+
+struct CameraMatrices {
+    mat4 modelview, persp, fullview;            // std140: three row_major mat4s, 64 bytes apart
+};
+
+static GLuint buffer = 0;
+static CameraMatrices sent;
+
+void BindCameraBlock(GLuint program) {
+    GLuint index = glGetUniformBlockIndex(program, "Camera");
+    if (index != GL_INVALID_INDEX)
+        glUniformBlockBinding(program, index, cameraBlockBinding);
+}
+
+bool UpdateCameraBlock(const Camera &camera) {
+    CameraMatrices m = {camera.modelview, camera.persp, camera.fullview};
+    if (!buffer) {
+        // binding persists in the context, so is made once
+        glGenBuffers(1, &buffer);
+        glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+        glBufferData(GL_UNIFORM_BUFFER, sizeof(m), &m, GL_DYNAMIC_DRAW);
+        glBindBufferBase(GL_UNIFORM_BUFFER, cameraBlockBinding, buffer);
+    }
+    else if (!memcmp(&m, &sent, sizeof(m)))
+        return false;
+    else {
+        glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+        glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(m), &m);
+    }
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    sent = m;
+    return true;
+}
+
+void ReleaseCameraBlock() {
+    if (buffer)
+        glDeleteBuffers(1, &buffer);
+    buffer = 0;
+}
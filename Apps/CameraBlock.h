@@ -0,0 +1,36 @@
+// CameraBlock.h - camera matrices in one uniform buffer, shared by every program
+//
+// setting modelview and persp with SetUniform() in each program, each frame, re-sends
+// the same matrices several times a frame, changed or not; here the camera's modelview,
+// persp and fullview live in one uniform buffer, bound once to a fixed binding point
+// that every program's "Camera" block is attached to, and re-sent only when they differ
+// from what was last sent (ie, after a drag, wheel or resize changed the camera)
+//
+// shaders (GLSL 1.40 or later) declare, in place of the matrix uniforms:
+//     layout (std140, row_major) uniform Camera { mat4 modelview, persp, fullview; };
+// (row_major, as VecMat stores matrices by row) and use the names as before
+//
+// usage:
+//     program = LinkProgramViaCode(...);
+//     BindCameraBlock(program);                   // once per program, after link
+//     void Display() { UpdateCameraBlock(camera); ...draw with any of the programs... }
+
+#ifndef CAMERA_BLOCK_HDR
+#define CAMERA_BLOCK_HDR
+
+#include <glad.h>
+#include "Camera.h"
+
+extern const GLuint cameraBlockBinding;
+    // uniform buffer binding point of the block (0)
+
+void BindCameraBlock(GLuint program);
+    // attach program's "Camera" block, if it has one, to the shared buffer
+
+bool UpdateCameraBlock(const Camera &camera);
+    // send camera's matrices if changed since last sent; return true if sent
+
+void ReleaseCameraBlock();
+    // delete the buffer (with the context current)
+
+#endif
@@ -0,0 +1,57 @@
+// FrameClock.cpp - monotonic animation clock and rolling frame-time statistics
+
+#include <algorithm>
+#include <stdio.h>
+#include "FrameClock.h"
+
+FrameClock::FrameClock() {
+    Reset();
+}
+
+void FrameClock::Reset() {
+    last = Clock::now();
+    time = 0;
+    delta = 0;
+    nFrames = 0;
+    ticked = false;
+}
+
+void FrameClock::SetFixedStep(float seconds) {
+    fixedStep = seconds > 0? seconds : 0;
+}
+
+void FrameClock::Tick() {
+    Clock::time_point now = Clock::now();
+    float seconds = std::chrono::duration<float>(now-last).count();
+    last = now;
+    // the first Tick follows setup, not a frame: no sample, and real-time animation starts at 0
+    if (ticked)
+        samples[nFrames++%nSamples] = 1000*seconds;
+    delta = fixedStep > 0? fixedStep : ticked? seconds : 0;
+    time += delta;
+    ticked = true;
+}
+
+float FrameClock::AverageMs() const {
+    int n = std::min(nFrames, nSamples);
+    float sum = 0;
+    for (int i = 0; i < n; i++)
+        sum += samples[i];
+    return n? sum/n : 0;
+}
+
+float FrameClock::PercentileMs(float p) const {
+    int n = std::min(nFrames, nSamples);
+    if (!n)
+        return 0;
+    float sorted[nSamples];
+    std::copy(samples, samples+n, sorted);
+    int k = std::min(n-1, std::max(0, (int) (p/100*n+.5f)-1));
+    std::nth_element(sorted, sorted+k, sorted+n);
+    return sorted[k];
+}
+
+void FrameClock::Report(const char *name) const {
+    printf("%s: %i frames, last %i: avg %.2f ms, p95 %.2f ms, p99 %.2f ms\n", name, nFrames,
+           std::min(nFrames, nSamples), AverageMs(), PercentileMs(95), PercentileMs(99));
+}
@@ -0,0 +1,55 @@
+// FrameClock.h - monotonic animation clock and rolling frame-time statistics
+//
+// clock() counts process CPU time (summed over threads, paused while the process
+// waits on vsync or the GPU), so animation driven by it runs at the wrong speed and
+// changes whenever rendering cost changes; here time comes from std::chrono's
+// steady clock, and each Tick() records the wall time since the previous frame
+// in a ring of recent frames for average and p95/p99 frame time
+//
+// in fixed-step mode (benchmarks) each Tick() advances animation time by exactly
+// the step, so every run renders the same sequence of frames however fast it goes;
+// frame-time statistics still measure real time
+//
+// usage:
+//     FrameClock frameClock;
+//     if (bench) frameClock.SetFixedStep(1/60.f);
+//     void Display() { frameClock.Tick(); float t = (float) frameClock.Time(); ... }
+//     frameClock.Report("app");                       // avg/p95/p99 frame ms
+
+#ifndef FRAMECLOCK_HDR
+#define FRAMECLOCK_HDR
+
+#include <chrono>
+
+class FrameClock {
+public:
+    static const int nSamples = 256;        // frames in the rolling window
+    FrameClock();
+    void Tick();
+        // once per frame: advance animation time, record frame time
+    void SetFixedStep(float seconds);
+        // seconds > 0: deterministic animation, advancing seconds per Tick; 0: real time
+    void Reset();
+        // animation time to 0, statistics cleared
+    double Time() const { return time; }
+        // animation time (seconds) at the last Tick
+    float Delta() const { return delta; }
+        // animation seconds advanced by the last Tick
+    int Frames() const { return nFrames; }
+        // frames timed since Reset (the window holds the last nSamples)
+    float AverageMs() const;
+    float PercentileMs(float p) const;
+        // frame time at or below which p percent of recent frames fall (eg, 95, 99)
+    void Report(const char *name) const;
+        // print frame count, average, p95 and p99 frame time
+private:
+    typedef std::chrono::steady_clock Clock;
+    Clock::time_point last;
+    double time = 0;
+    float delta = 0, fixedStep = 0;
+    float samples[nSamples];                // frame milliseconds, ring buffer
+    int nFrames = 0;                        // frame times recorded
+    bool ticked = false;
+};
+
+#endif
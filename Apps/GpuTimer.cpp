@@ -0,0 +1,108 @@
+// GpuTimer.cpp - GPU time of named sections of Display(), via timestamp queries
+
+#include <string.h>
+#include "GpuTimer.h"
+
+int GpuTimer::Find(const char *name) const {
+    // pointer compare first (string literals), then by content
+    for (int i = 0; i < (int) sections.size(); i++)
+        if (sections[i].name == name)
+            return i;
+    for (int i = 0; i < (int) sections.size(); i++)
+        if (!strcmp(sections[i].name, name))
+            return i;
+    return -1;
+}
+
+void GpuTimer::Begin(const char *name) {
+    int i = Find(name);
+    if (i < 0) {
+        i = (int) sections.size();
+        sections.push_back(Section());
+        Section &s = sections.back();
+        s.name = name;
+        glGenQueries(2*nSlots, &s.queries[0][0]);
+        memset(s.issued, 0, sizeof(s.issued));
+    }
+    Section &s = sections[i];
+    int slot = frame%nSlots;
+    glQueryCounter(s.queries[slot][0], GL_TIMESTAMP);
+    s.issued[slot] = true;
+    open.push_back(i);
+}
+
+void GpuTimer::End() {
+    if (open.empty())
+        return;
+    Section &s = sections[open.back()];
+    open.pop_back();
+    glQueryCounter(s.queries[frame%nSlots][1], GL_TIMESTAMP);
+}
+
+void GpuTimer::Collect(int slot) {
+    for (Section &s : sections) {
+        if (!s.issued[slot])
+            continue;
+        // timestamps complete in order, so once the end is available so is the start
+        GLint ready = 0;
+        glGetQueryObjectiv(s.queries[slot][1], GL_QUERY_RESULT_AVAILABLE, &ready);
+        if (!ready)
+            continue;
+        GLuint64 t0 = 0, t1 = 0;
+        glGetQueryObjectui64v(s.queries[slot][0], GL_QUERY_RESULT, &t0);
+        glGetQueryObjectui64v(s.queries[slot][1], GL_QUERY_RESULT, &t1);
+        s.lastMs = t1 > t0? (float) ((t1-t0)/1e6) : 0;
+        s.history[s.nTimed++%nHistory] = s.lastMs;
+        s.issued[slot] = false;
+    }
+}
+
+void GpuTimer::CollectReady() {
+    // oldest slot first (the one the next frame reuses), so history stays in frame order
+    for (int k = 0; k < nSlots; k++)
+        Collect((frame+k)%nSlots);
+}
+
+void GpuTimer::EndFrame() {
+    frame++;
+    CollectReady();
+    // results still pending in the slot the next frame reuses are dropped, not waited for
+    int slot = frame%nSlots;
+    for (Section &s : sections)
+        if (s.issued[slot]) {
+            s.issued[slot] = false;
+            s.nDropped++;
+        }
+}
+
+float GpuTimer::LastMs(const char *name) const {
+    int i = Find(name);
+    return i < 0? 0 : sections[i].lastMs;
+}
+
+float GpuTimer::AverageMs(const char *name) const {
+    int i = Find(name);
+    if (i < 0 || !sections[i].nTimed)
+        return 0;
+    const Section &s = sections[i];
+    int n = s.nTimed < nHistory? s.nTimed : nHistory;
+    float sum = 0;
+    for (int k = 0; k < n; k++)
+        sum += s.history[k];
+    return sum/n;
+}
+
+void GpuTimer::Report(FILE *out) {
+    // an event-driven loop may stop drawing with several frames uncollected
+    CollectReady();
+    fprintf(out, "GPU ms (last frame, average of last %i, frames dropped):\n", nHistory);
+    for (const Section &s : sections)
+        fprintf(out, "    %-12s %8.3f %8.3f %6i\n", s.name, s.lastMs, AverageMs(s.name), s.nDropped);
+}
+
+void GpuTimer::Release() {
+    for (Section &s : sections)
+        glDeleteQueries(2*nSlots, &s.queries[0][0]);
+    sections.clear();
+    open.clear();
+}
@@ -0,0 +1,63 @@
+// GpuTimer.h - GPU time of named sections of Display(), via timestamp queries
+//
+// CPU timers around draw calls measure only command submission; the GPU runs
+// behind. Here each section records a GL_TIMESTAMP query at its start and end
+// (timestamps, unlike GL_TIME_ELAPSED, may nest); queries live in a ring of
+// frames, and results are read only once GL reports them available, so the read
+// never stalls: each EndFrame() and Report() collects whatever frames are ready,
+// oldest first, and a frame still pending when its slot is reused is dropped
+// (counted, not waited for). Per section the last frame and a rolling average are kept
+//
+// usage:
+//     GpuTimer gpuTimer;
+//     void Display() {
+//         gpuTimer.Begin("patch"); ...draw...; gpuTimer.End();
+//         gpuTimer.Begin("overlay"); ...draw...; gpuTimer.End();
+//         gpuTimer.EndFrame();
+//     }
+//     gpuTimer.Report(stdout);                            // or a file
+//
+// needs GL 3.3 or ARB_timer_query (llvmpipe has it); elsewhere sections read 0
+
+#ifndef GPUTIMER_HDR
+#define GPUTIMER_HDR
+
+#include <glad.h>
+#include <stdio.h>
+#include <vector>
+
+class GpuTimer {
+public:
+    static const int nSlots = 4;            // frames in flight before results are read
+    static const int nHistory = 64;         // frames in the rolling average
+    void Begin(const char *name);
+    void End();
+        // bracket a section; name is kept as a pointer (eg, a string literal)
+    void EndFrame();
+        // mark end of frame; collect results that are ready
+    float LastMs(const char *name) const;
+    float AverageMs(const char *name) const;
+        // most recent and rolling-average GPU milliseconds for section name (0 if unknown)
+    void Report(FILE *out = stdout);
+        // collect results that are ready, then one line per section: last and average
+        // milliseconds, and frames dropped
+    void Release();
+        // delete query objects (needs a current context)
+private:
+    struct Section {
+        const char *name;
+        GLuint queries[nSlots][2];          // start, end timestamps
+        bool issued[nSlots];                // section ran in the frame using this slot
+        float history[nHistory];
+        int nTimed = 0, nDropped = 0;
+        float lastMs = 0;
+    };
+    std::vector<Section> sections;
+    std::vector<int> open;                  // stack of sections begun and not ended
+    int frame = 0;
+    int Find(const char *name) const;
+    void Collect(int slot);
+    void CollectReady();
+};
+
+#endif
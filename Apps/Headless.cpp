@@ -0,0 +1,276 @@
+// Headless.cpp - offscreen GL context and benchmark loop for an app's Display()
+
+#include <glad.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+#include <chrono>
+#include <vector>
+#include "Camera.h"
+#include "Headless.h"
+
+#if defined(_WIN32) || defined(__APPLE__)
+#include <GLFW/glfw3.h>
+#define HEADLESS_GLFW
+#else
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#ifndef EGL_PLATFORM_SURFACELESS_MESA
+#define EGL_PLATFORM_SURFACELESS_MESA 0x31DD
+#endif
+#endif
+
+// options
+
+static int  nFrames = 300, nWarmup = 10;
+static int  benchWidth = 0, benchHeight = 0;
+static const char *outFilename = NULL;
+
+bool HeadlessArgs(int ac, char **av) {
+    bool bench = false;
+    for (int i = 1; i < ac; i++) {
+        if (!strcmp(av[i], "--bench")) {
+            bench = true;
+            if (i+1 < ac && atoi(av[i+1]) > 0)
+                nFrames = atoi(av[++i]);
+        }
+        else if (!strcmp(av[i], "--size") && i+1 < ac)
+            sscanf(av[++i], "%dx%d", &benchWidth, &benchHeight);
+        else if (!strcmp(av[i], "--out") && i+1 < ac)
+            outFilename = av[++i];
+    }
+    return bench;
+}
+
+// context
+
+#ifdef HEADLESS_GLFW
+static GLFWwindow *window = NULL;
+#else
+static EGLDisplay display = EGL_NO_DISPLAY;
+static EGLContext context = EGL_NO_CONTEXT;
+static EGLSurface surface = EGL_NO_SURFACE;
+#endif
+
+static GLuint framebuffer = 0, colorbuffer = 0, depthbuffer = 0;
+static int width = 0, height = 0;
+
+static bool Error(const char *msg) {
+    fprintf(stderr, "Headless: %s\n", msg);
+    return false;
+}
+
+#ifdef HEADLESS_GLFW
+
+static bool CreateContext() {
+    if (!glfwInit())
+        return Error("can't init GLFW");
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    if (!(window = glfwCreateWindow(width, height, "", NULL, NULL)))
+        return Error("can't create hidden window");
+    glfwMakeContextCurrent(window);
+    glfwSwapInterval(0);
+    return gladLoadGLLoader((GLADloadproc) glfwGetProcAddress) != 0;
+}
+
+static void DestroyContext() {
+    glfwDestroyWindow(window);
+    glfwTerminate();
+}
+
+#else
+
+static bool CreateContext() {
+    // prefer Mesa's surfaceless platform: needs neither X nor a GPU
+    PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+        (PFNEGLGETPLATFORMDISPLAYEXTPROC) eglGetProcAddress("eglGetPlatformDisplayEXT");
+    if (getPlatformDisplay)
+        display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+    if (display == EGL_NO_DISPLAY)
+        display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    if (display == EGL_NO_DISPLAY || !eglInitialize(display, NULL, NULL))
+        return Error("can't init EGL display");
+    EGLint pbufferAttribs[] = {EGL_SURFACE_TYPE, EGL_PBUFFER_BIT, EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+                               EGL_RED_SIZE, 8, EGL_GREEN_SIZE, 8, EGL_BLUE_SIZE, 8, EGL_DEPTH_SIZE, 24, EGL_NONE};
+    EGLint anyAttribs[] = {EGL_SURFACE_TYPE, 0, EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT, EGL_NONE};
+    EGLConfig config;
+    EGLint nConfigs = 0;
+    bool pbuffer = eglChooseConfig(display, pbufferAttribs, &config, 1, &nConfigs) && nConfigs > 0;
+    if (!pbuffer && (!eglChooseConfig(display, anyAttribs, &config, 1, &nConfigs) || nConfigs < 1))
+        return Error("no EGL config supports desktop GL");
+    if (!eglBindAPI(EGL_OPENGL_API))
+        return Error("can't bind desktop GL API");
+    // default (compatibility) context: apps use GL_QUADS and client-side index arrays
+    if ((context = eglCreateContext(display, config, EGL_NO_CONTEXT, NULL)) == EGL_NO_CONTEXT)
+        return Error("can't create EGL context");
+    if (pbuffer) {
+        EGLint surfaceAttribs[] = {EGL_WIDTH, width, EGL_HEIGHT, height, EGL_NONE};
+        surface = eglCreatePbufferSurface(display, config, surfaceAttribs);
+    }
+    // without a pbuffer rely on EGL_KHR_surfaceless_context; we render to our own framebuffer anyway
+    if (!eglMakeCurrent(display, surface, surface, context))
+        return Error("can't make EGL context current");
+    return gladLoadGLLoader((GLADloadproc) eglGetProcAddress) != 0;
+}
+
+static void DestroyContext() {
+    eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    if (surface != EGL_NO_SURFACE)
+        eglDestroySurface(display, surface);
+    eglDestroyContext(display, context);
+    eglTerminate(display);
+}
+
+#endif
+
+// draw call counting: wrap glad's entry points so apps need no changes
+
+static int nDrawCalls = 0;
+static PFNGLDRAWARRAYSPROC drawArrays = NULL;
+static PFNGLDRAWELEMENTSPROC drawElements = NULL;
+static PFNGLDRAWARRAYSINSTANCEDPROC drawArraysInstanced = NULL;
+static PFNGLDRAWELEMENTSINSTANCEDPROC drawElementsInstanced = NULL;
+
+static void APIENTRY CountDrawArrays(GLenum mode, GLint first, GLsizei count) {
+    nDrawCalls++;
+    drawArrays(mode, first, count);
+}
+
+static void APIENTRY CountDrawElements(GLenum mode, GLsizei count, GLenum type, const void *indices) {
+    nDrawCalls++;
+    drawElements(mode, count, type, indices);
+}
+
+static void APIENTRY CountDrawArraysInstanced(GLenum mode, GLint first, GLsizei count, GLsizei n) {
+    nDrawCalls++;
+    drawArraysInstanced(mode, first, count, n);
+}
+
+static void APIENTRY CountDrawElementsInstanced(GLenum mode, GLsizei count, GLenum type, const void *indices, GLsizei n) {
+    nDrawCalls++;
+    drawElementsInstanced(mode, count, type, indices, n);
+}
+
+static void HookDrawCalls() {
+    drawArrays = glad_glDrawArrays;
+    drawElements = glad_glDrawElements;
+    drawArraysInstanced = glad_glDrawArraysInstanced;
+    drawElementsInstanced = glad_glDrawElementsInstanced;
+    glad_glDrawArrays = CountDrawArrays;
+    glad_glDrawElements = CountDrawElements;
+    if (drawArraysInstanced)
+        glad_glDrawArraysInstanced = CountDrawArraysInstanced;
+    if (drawElementsInstanced)
+        glad_glDrawElementsInstanced = CountDrawElementsInstanced;
+}
+
+bool InitHeadless(int w, int h) {
+    width = benchWidth > 0? benchWidth : w;
+    height = benchHeight > 0? benchHeight : h;
+    if (!CreateContext())
+        return false;
+    // offscreen color and depth targets; apps never bind another framebuffer
+    glGenRenderbuffers(1, &colorbuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, colorbuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+    glGenRenderbuffers(1, &depthbuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, depthbuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+    glGenFramebuffers(1, &framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, colorbuffer);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depthbuffer);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+        return Error("offscreen framebuffer incomplete");
+    glViewport(0, 0, width, height);
+    HookDrawCalls();
+    return true;
+}
+
+void HeadlessSize(int *w, int *h) {
+    *w = width;
+    *h = height;
+}
+
+// benchmark
+
+static float Percentile(std::vector<float> &sorted, float p) {
+    int i = (int) ceil(p*sorted.size())-1;
+    return sorted[std::max(0, std::min(i, (int) sorted.size()-1))];
+}
+
+int RunHeadless(const char *appName, void (*display)(), Camera *camera, void (*finish)()) {
+    using namespace std::chrono;
+    std::vector<float> frameMs;
+    double nCalls = 0, nPrimitives = 0, totalMs = 0;
+    GLuint query = 0;
+    glGenQueries(1, &query);
+    if (camera) {
+        camera->Resize(width, height);
+        camera->MouseDown(width/2, height/2);
+    }
+    for (int i = -nWarmup; i < nFrames; i++) {
+        if (camera) {
+            // one full orbit about y over the run, with a gentle bob about x
+            float a = (float) (i+nWarmup)/(nFrames+nWarmup);
+            camera->MouseDrag(width/2+(int) (1200*a), height/2+(int) (60*sin(6.2832f*a)), false);
+        }
+        nDrawCalls = 0;
+        glBeginQuery(GL_PRIMITIVES_GENERATED, query);
+        steady_clock::time_point t0 = steady_clock::now();
+        display();
+        glEndQuery(GL_PRIMITIVES_GENERATED);
+        glFinish();
+        float ms = duration<float, std::milli>(steady_clock::now()-t0).count();
+        GLuint nPrims = 0;
+        glGetQueryObjectuiv(query, GL_QUERY_RESULT, &nPrims);
+        if (i < 0)
+            continue;
+        frameMs.push_back(ms);
+        totalMs += ms;
+        nCalls += nDrawCalls;
+        nPrimitives += nPrims;
+    }
+    if (camera)
+        camera->MouseUp();
+    glDeleteQueries(1, &query);
+    // report
+    std::vector<float> sorted(frameMs);
+    std::sort(sorted.begin(), sorted.end());
+    float mean = nFrames? (float) (totalMs/nFrames) : 0, secs = (float) (totalMs/1000);
+    const char *renderer = (const char *) glGetString(GL_RENDERER);
+    FILE *out = outFilename? fopen(outFilename, "w") : stdout;
+    if (!out) {
+        fprintf(stderr, "Headless: can't write %s\n", outFilename);
+        out = stdout;
+    }
+    fprintf(out, "{\n");
+    fprintf(out, "  \"app\": \"%s\",\n", appName);
+    fprintf(out, "  \"renderer\": \"");
+    for (const char *c = renderer? renderer : ""; *c; c++)
+        fprintf(out, *c == '"' || *c == '\\'? "\\%c" : "%c", *c);
+    fprintf(out, "\",\n");
+    fprintf(out, "  \"width\": %d,\n  \"height\": %d,\n  \"frames\": %d,\n", width, height, nFrames);
+    if (nFrames)
+        fprintf(out, "  \"frame_ms\": {\"min\": %.4f, \"median\": %.4f, \"p95\": %.4f, \"p99\": %.4f, \"mean\": %.4f},\n",
+                sorted.front(), Percentile(sorted, .5f), Percentile(sorted, .95f), Percentile(sorted, .99f), mean);
+    fprintf(out, "  \"fps\": %.2f,\n", mean > 0? 1000/mean : 0);
+    fprintf(out, "  \"draw_calls_per_frame\": %.1f,\n", nFrames? nCalls/nFrames : 0);
+    fprintf(out, "  \"primitives_per_frame\": %.1f,\n", nFrames? nPrimitives/nFrames : 0);
+    fprintf(out, "  \"draw_calls_per_sec\": %.1f,\n", secs > 0? nCalls/secs : 0);
+    fprintf(out, "  \"primitives_per_sec\": %.1f\n", secs > 0? nPrimitives/secs : 0);
+    fprintf(out, "}\n");
+    if (out != stdout)
+        fclose(out);
+    if (finish)
+        finish();
+    // release
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glDeleteFramebuffers(1, &framebuffer);
+    glDeleteRenderbuffers(1, &colorbuffer);
+    glDeleteRenderbuffers(1, &depthbuffer);
+    DestroyContext();
+    return 0;
+}
@@ -0,0 +1,30 @@
+// Headless.h - offscreen GL context and benchmark loop for an app's Display()
+//
+// usage: app --bench [nFrames] [--size WxH] [--out file.json]
+//   the app creates its GL context with InitHeadless() instead of a GLFW window,
+//   performs its usual shader/buffer setup, then hands Display() to RunHeadless(),
+//   which renders nFrames into an offscreen framebuffer while orbiting the camera
+//   and reports frame time (min/median/p95/p99), draw calls and primitives as JSON
+
+#ifndef HEADLESS_HDR
+#define HEADLESS_HDR
+
+class Camera;
+
+bool HeadlessArgs(int ac, char **av);
+    // parse benchmark arguments; return true if --bench present
+
+bool InitHeadless(int width, int height);
+    // create offscreen context (EGL on Linux, so llvmpipe works without a GPU;
+    // hidden GLFW window elsewhere), load GL entry points, bind a width x height framebuffer
+    // --size on the command line overrides width and height
+
+void HeadlessSize(int *width, int *height);
+    // size of the offscreen framebuffer (stands in for glfwGetWindowSize)
+
+int RunHeadless(const char *appName, void (*display)(), Camera *camera = 0, void (*finish)() = 0);
+    // render benchmark frames with a scripted camera orbit (if camera non-null),
+    // print/write results, call finish (if non-null) while the context is still
+    // current (eg, to read GPU queries), release context; return process exit code
+
+#endif
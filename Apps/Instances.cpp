@@ -0,0 +1,102 @@
+// Instances.cpp - per-instance model matrices and tints, for drawing one mesh many times
+
+#include <stddef.h>
+#include <algorithm>
+#include "Instances.h"
+#include "Uniforms.h"
+
+void InstanceBuffer::Resize(int n) {
+    Instance identity = {{vec4(1, 0, 0, 0), vec4(0, 1, 0, 0), vec4(0, 0, 1, 0)}, vec4(1, 1, 1, 1)};
+    instances.resize(n, identity);
+    pending.assign(n, false);
+    changed.clear();
+    all = true;
+}
+
+void InstanceBuffer::Set(int i, const mat4 &model, vec4 tint) {
+    Instance &r = instances[i];
+    for (int k = 0; k < 3; k++)
+        r.model[k] = model[k];
+    r.tint = tint;
+    if (!all && !pending[i]) {
+        pending[i] = true;
+        changed.push_back(i);
+    }
+}
+
+bool InstanceBuffer::Attributes(Mesh &mesh, GLuint program, const char *model, const char *tint) {
+    if (!buffer)
+        glGenBuffers(1, &buffer);
+    GLint m = AttributeLocation(program, model), t = AttributeLocation(program, tint);
+    if (m < 0)
+        return false;
+    // pointer state is captured by the mesh's VAO, sourced from this buffer, one record per instance
+    glBindVertexArray(mesh.vao);
+    glBindBuffer(GL_ARRAY_BUFFER, buffer);
+    for (int k = 0; k < 3; k++) {
+        VertexAttribPointer(m+k, 4, sizeof(Instance), (void *) (offsetof(Instance, model)+k*sizeof(vec4)));
+        glVertexAttribDivisor(m+k, 1);
+    }
+    if (VertexAttribPointer(t, 4, sizeof(Instance), (void *) offsetof(Instance, tint)))
+        glVertexAttribDivisor(t, 1);
+    glBindVertexArray(0);
+    return true;
+}
+
+int InstanceBuffer::Upload() {
+    int n = Count(), nChanged = (int) changed.size(), nSent = 0;
+    if (!buffer)
+        glGenBuffers(1, &buffer);
+    glBindBuffer(GL_ARRAY_BUFFER, buffer);
+    if (all || n > capacity || nChanged > n/8) {
+        // orphan: the driver gives new storage rather than waiting on draws from the old
+        capacity = std::max(n, capacity);
+        glBufferData(GL_ARRAY_BUFFER, capacity*sizeof(Instance), NULL, GL_STREAM_DRAW);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, n*sizeof(Instance), instances.data());
+        nSent = n;
+    }
+    else if (nChanged) {
+        // runs of consecutive ids, one glBufferSubData each
+        std::sort(changed.begin(), changed.end());
+        for (int i = 0; i < nChanged; ) {
+            int first = changed[i], last = first;
+            while (++i < nChanged && changed[i] == last+1)
+                last++;
+            glBufferSubData(GL_ARRAY_BUFFER, first*sizeof(Instance), (last-first+1)*sizeof(Instance), &instances[first]);
+        }
+        nSent = nChanged;
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    for (int i : changed)
+        pending[i] = false;
+    changed.clear();
+    all = false;
+    return nSent;
+}
+
+int InstanceBuffer::Upload(const int *ids, int n) {
+    selected.resize(n);
+    for (int i = 0; i < n; i++)
+        selected[i] = instances[ids[i]];
+    if (!buffer)
+        glGenBuffers(1, &buffer);
+    glBindBuffer(GL_ARRAY_BUFFER, buffer);
+    capacity = std::max(Count(), capacity);
+    glBufferData(GL_ARRAY_BUFFER, capacity*sizeof(Instance), NULL, GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, n*sizeof(Instance), selected.data());
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    // the buffer no longer mirrors instances, so the next Upload() sends all
+    for (int i : changed)
+        pending[i] = false;
+    changed.clear();
+    all = true;
+    return n;
+}
+
+void InstanceBuffer::Release() {
+    if (buffer)
+        glDeleteBuffers(1, &buffer);
+    buffer = 0;
+    capacity = 0;
+    all = true;
+}
@@ -0,0 +1,67 @@
+// Instances.h - per-instance model matrices and tints, for drawing one mesh many times
+//
+// drawing a crowd as one glDrawElements per copy, each after a SetUniform of its
+// model matrix, costs CPU time per copy; here each instance's transform and tint are
+// records in a vertex buffer, attached to the mesh's VAO with a divisor of 1, so a single
+// IndexBuffer::DrawInstanced draws them all, and the shader reads them as attributes
+//
+// only changed records are re-sent: Set() notes the instance, Upload() sends runs of
+// noted instances with glBufferSubData, or, if more than an eighth changed (or the
+// count grew), orphans the buffer and streams all of it, so the upload need not wait
+// for the GPU to finish drawing from the old contents; a frame that changes k instances
+// costs O(k), however many are drawn
+//
+// the model matrix is sent as its top three rows (affine: the fourth is 0, 0, 0, 1); in
+// the vertex shader, as columns of a mat3x4, so that vector*matrix gives the row products:
+//     in mat3x4 model;
+//     in vec4 tint;
+//     ...vec3 p = vec4(point, 1)*model;     // model*point
+//
+// usage:
+//     instances.Resize(n);
+//     for (int i = 0; i < n; i++) instances.Set(i, Translate(...)*RotateY(...), tint);
+//     instances.Attributes(mesh, program);         // after the mesh's own attributes
+//     ...
+//     instances.Upload();                          // once per frame (no-op if unchanged)
+//     mesh.Bind();
+//     indices.DrawInstanced(GL_TRIANGLES, instances.Count());
+
+#ifndef INSTANCES_HDR
+#define INSTANCES_HDR
+
+#include <glad.h>
+#include <vector>
+#include "Mesh.h"
+#include "VecMat.h"
+
+class InstanceBuffer {
+public:
+    struct Instance {
+        vec4 model[3];          // rows 0-2 of the model matrix
+        vec4 tint;              // rgb, a free for the shader
+    };
+    GLuint buffer = 0;
+    int Count() const { return (int) instances.size(); }
+    void Resize(int n);
+        // n instances, new ones identity and white
+    void Set(int i, const mat4 &model, vec4 tint = vec4(1, 1, 1, 1));
+    const Instance &Get(int i) const { return instances[i]; }
+    bool Attributes(Mesh &mesh, GLuint program, const char *model = "model", const char *tint = "tint");
+        // record per-instance layout in mesh's VAO (a mat3x4 takes three locations);
+        // false if model not active in program
+    int Upload();
+        // send changed instances; return the number sent
+    int Upload(const int *ids, int n);
+        // send only instances ids[0, n), in that order (eg, those in view), for
+        // DrawInstanced(mode, n); always a full, orphaned upload, O(n)
+    void Release();
+private:
+    std::vector<Instance> instances;
+    std::vector<int> changed;           // ids Set() since the last Upload()
+    std::vector<bool> pending;          // per instance: in changed
+    std::vector<Instance> selected;     // staging for Upload(ids, n)
+    int capacity = 0;                   // buffer size, in instances
+    bool all = true;                    // resend everything
+};
+
+#endif
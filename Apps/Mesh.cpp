@@ -0,0 +1,102 @@
+// Mesh.cpp - GPU vertex buffer plus a vertex array object that records its attribute layout,
+//            and an index buffer for glDrawElements
+
+#include <vector>
+#include "Mesh.h"
+#include "Uniforms.h"
+
+void Mesh::Allocate(int nbytes, const void *data, GLenum usage) {
+    if (!vao)
+        glGenVertexArrays(1, &vao);
+    if (!vBuffer)
+        glGenBuffers(1, &vBuffer);
+    glBindBuffer(GL_ARRAY_BUFFER, vBuffer);
+    glBufferData(GL_ARRAY_BUFFER, nbytes, data, usage);
+}
+
+void Mesh::SubData(int offset, int nbytes, const void *data) {
+    glBindBuffer(GL_ARRAY_BUFFER, vBuffer);
+    glBufferSubData(GL_ARRAY_BUFFER, offset, nbytes, data);
+}
+
+bool Mesh::Attribute(GLuint program, const char *name, int ncomponents, int stride, size_t offset) {
+    // pointer state is captured by the VAO, sourced from vBuffer
+    glBindVertexArray(vao);
+    glBindBuffer(GL_ARRAY_BUFFER, vBuffer);
+    bool ok = VertexAttribPointer(AttributeLocation(program, name), ncomponents, stride, (void *) offset);
+    glBindVertexArray(0);
+    return ok;
+}
+
+void Mesh::Attach(IndexBuffer &indices) {
+    // element buffer binding is VAO state
+    glBindVertexArray(vao);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indices.buffer);
+    glBindVertexArray(0);
+    indices.inVao = true;
+}
+
+void Mesh::Bind() {
+    glBindVertexArray(vao);
+}
+
+void Mesh::Unbind() {
+    glBindVertexArray(0);
+}
+
+void Mesh::Release() {
+    if (vBuffer)
+        glDeleteBuffers(1, &vBuffer);
+    if (vao)
+        glDeleteVertexArrays(1, &vao);
+    vBuffer = vao = 0;
+}
+
+// index buffer
+
+void IndexBuffer::Allocate(const int *ids, int n, int nVertices, GLenum usage) {
+    if (nVertices < 0)
+        for (int i = 0; i < n; i++)
+            nVertices = ids[i] >= nVertices? ids[i]+1 : nVertices;
+    count = n;
+    type = nVertices <= 65536? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+    if (!buffer)
+        glGenBuffers(1, &buffer);
+    // uploaded through the copy target, which, unlike the element target, is not
+    // part of whatever VAO is bound
+    glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+    if (type == GL_UNSIGNED_SHORT) {
+        // narrow to 16 bits: half the memory and fetch bandwidth
+        std::vector<GLushort> narrow(ids, ids+n);
+        glBufferData(GL_COPY_WRITE_BUFFER, n*sizeof(GLushort), narrow.data(), usage);
+    }
+    else
+        glBufferData(GL_COPY_WRITE_BUFFER, n*sizeof(GLuint), ids, usage);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+}
+
+void IndexBuffer::Draw(GLenum mode, int first, int n) {
+    int size = type == GL_UNSIGNED_SHORT? 2 : 4;
+    if (!inVao)
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffer);
+    glDrawElements(mode, n < 0? count-first : n, type, (void *) ((size_t) first*size));
+    if (!inVao)
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+}
+
+void IndexBuffer::DrawInstanced(GLenum mode, int nInstances, int first, int n) {
+    int size = type == GL_UNSIGNED_SHORT? 2 : 4;
+    if (!inVao)
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffer);
+    glDrawElementsInstanced(mode, n < 0? count-first : n, type, (void *) ((size_t) first*size), nInstances);
+    if (!inVao)
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+}
+
+void IndexBuffer::Release() {
+    if (buffer)
+        glDeleteBuffers(1, &buffer);
+    buffer = 0;
+    count = 0;
+    inVao = false;
+}
@@ -0,0 +1,71 @@
+// Mesh.h - GPU vertex buffer plus a vertex array object that records its attribute layout,
+//          and an index buffer for glDrawElements
+//
+// attribute pointers are set once, when the mesh is built; at draw time a single
+// Bind() restores buffer and layout, replacing per-frame VertexAttribPointer calls
+//
+// usage:
+//     mesh.Allocate(sizePts+sizeNms);
+//     mesh.SubData(0, sizePts, points);
+//     mesh.SubData(sizePts, sizeNms, normals);
+//     mesh.Attribute(program, "point", 3, 0, 0);
+//     mesh.Attribute(program, "normal", 3, 0, sizePts);
+//     ...
+//     mesh.Bind();
+//     glDrawElements(...);
+//     mesh.Unbind();       // Draw.h overlays (Disk, Line) set pointers on the default VAO
+// Allocate() and Attribute() leave no VAO bound, so later setup can't edit this one
+//
+// client-side index arrays passed to glDrawElements are re-sent to the GPU every draw;
+// an IndexBuffer uploads them once, as 16-bit ids when the vertex count allows, and
+// Attach() records it in the mesh's VAO, so Bind() restores it with the layout:
+//     indices.Allocate(&triangles[0][0], 3*ntriangles);
+//     mesh.Attach(indices);
+//     ...
+//     mesh.Bind();
+//     indices.Draw(GL_TRIANGLES);
+
+#ifndef MESH_HDR
+#define MESH_HDR
+
+#include <glad.h>
+
+class IndexBuffer;
+
+class Mesh {
+public:
+    GLuint vao = 0, vBuffer = 0;
+    void Allocate(int nbytes, const void *data = NULL, GLenum usage = GL_STATIC_DRAW);
+        // create VAO and vertex buffer (if needed), size buffer and optionally fill it
+    void SubData(int offset, int nbytes, const void *data);
+        // copy data into part of the vertex buffer
+    bool Attribute(GLuint program, const char *name, int ncomponents, int stride, size_t offset);
+        // record float attribute layout in the VAO; false if name not active in program
+    void Attach(IndexBuffer &indices);
+        // record indices as the VAO's element buffer (once: it persists through re-Allocate)
+    void Bind();
+    static void Unbind();
+    void Release();
+        // delete GL objects (needs a current context, so not done by a destructor)
+};
+
+class IndexBuffer {
+public:
+    GLuint buffer = 0;
+    GLenum type = GL_UNSIGNED_INT;          // GL_UNSIGNED_SHORT if all ids < 65536
+    int count = 0;
+    bool inVao = false;                     // attached to a mesh's VAO, so draws need no bind
+    void Allocate(const int *ids, int count, int nVertices = -1, GLenum usage = GL_STATIC_DRAW);
+        // upload ids to an element buffer; nVertices (max id + 1) is found from ids if < 0
+    void Draw(GLenum mode, int first = 0, int n = -1);
+        // glDrawElements for n ids (all remaining if < 0) starting at id first, with the
+        // attached mesh bound; if not attached (drawing from the default VAO), the element
+        // buffer is bound for the draw and restored to 0 afterwards, so client-side
+        // glDrawElements elsewhere (eg, Draw.h) is unaffected
+    void DrawInstanced(GLenum mode, int nInstances, int first = 0, int n = -1);
+        // as Draw, but glDrawElementsInstanced: shaders select per-instance data by gl_InstanceID
+    int Bytes() const { return count*(type == GL_UNSIGNED_SHORT? 2 : 4); }
+    void Release();
+};
+
+#endif
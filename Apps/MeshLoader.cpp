@@ -0,0 +1,677 @@
+// MeshLoader.cpp - memory-mapped, multi-threaded OBJ and binary PLY readers
+
+#include <ctype.h>
+#include <float.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+#include <atomic>
+#include "MeshLoader.h"
+#include "Parallel.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using std::vector;
+
+// memory-mapped file
+
+class MappedFile {
+public:
+    const char *data = NULL;
+    size_t size = 0;
+    bool Open(const char *filename);
+    ~MappedFile();
+private:
+#ifdef _WIN32
+    HANDLE file = INVALID_HANDLE_VALUE, mapping = NULL;
+#else
+    int fd = -1;
+#endif
+};
+
+#ifdef _WIN32
+
+bool MappedFile::Open(const char *filename) {
+    file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+    LARGE_INTEGER fileSize;
+    GetFileSizeEx(file, &fileSize);
+    size = (size_t) fileSize.QuadPart;
+    if (size == 0)
+        return true;
+    mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    data = mapping? (const char *) MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : NULL;
+    return data != NULL;
+}
+
+MappedFile::~MappedFile() {
+    if (data)
+        UnmapViewOfFile(data);
+    if (mapping)
+        CloseHandle(mapping);
+    if (file != INVALID_HANDLE_VALUE)
+        CloseHandle(file);
+}
+
+#else
+
+bool MappedFile::Open(const char *filename) {
+    if ((fd = open(filename, O_RDONLY)) < 0)
+        return false;
+    struct stat s;
+    if (fstat(fd, &s) < 0)
+        return false;
+    size = (size_t) s.st_size;
+    if (size == 0)
+        return true;
+    void *p = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (p == MAP_FAILED)
+        return false;
+    madvise(p, size, MADV_SEQUENTIAL);
+    data = (const char *) p;
+    return true;
+}
+
+MappedFile::~MappedFile() {
+    if (data)
+        munmap((void *) data, size);
+    if (fd >= 0)
+        close(fd);
+}
+
+#endif
+
+static bool Error(const char *filename, const char *msg) {
+    printf("can't read %s: %s\n", filename, msg);
+    return false;
+}
+
+// number parsing, bounded by end (mapped data is not null-terminated)
+
+static inline bool IsDigit(char c) { return c >= '0' && c <= '9'; }
+
+static inline const char *SkipBlanks(const char *c, const char *end) {
+    while (c < end && (*c == ' ' || *c == '\t'))
+        c++;
+    return c;
+}
+
+static inline const char *SkipLine(const char *c, const char *end) {
+    while (c < end && *c != '\n')
+        c++;
+    return c < end? c+1 : end;
+}
+
+static inline const char *ParseInt(const char *c, const char *end, int &i) {
+    bool neg = c < end && *c == '-';
+    if (c < end && (*c == '-' || *c == '+'))
+        c++;
+    int v = 0;
+    while (c < end && IsDigit(*c))
+        v = 10*v+(*c++-'0');
+    i = neg? -v : v;
+    return c;
+}
+
+static inline const char *ParseFloat(const char *c, const char *end, float &f) {
+    static const double pow10[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10,
+                                   1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+    bool neg = c < end && *c == '-';
+    if (c < end && (*c == '-' || *c == '+'))
+        c++;
+    uint64_t mantissa = 0;
+    int nDigits = 0, exponent = 0;
+    for (; c < end && IsDigit(*c); c++)
+        if (nDigits < 19) {
+            mantissa = 10*mantissa+(*c-'0');
+            if (mantissa)
+                nDigits++;
+        }
+        else
+            exponent++;                         // digits beyond precision scale the value
+    if (c < end && *c == '.')
+        for (c++; c < end && IsDigit(*c); c++)
+            if (nDigits < 19) {
+                mantissa = 10*mantissa+(*c-'0');
+                if (mantissa)
+                    nDigits++;
+                exponent--;
+            }
+    if (c < end && (*c == 'e' || *c == 'E')) {
+        int e;
+        c = ParseInt(c+1, end, e);
+        exponent += e;
+    }
+    double v = (double) mantissa;
+    if (exponent < 0)
+        v = exponent >= -22? v/pow10[-exponent] : v*pow(10., exponent);
+    else if (exponent > 0)
+        v = exponent <= 22? v*pow10[exponent] : v*pow(10., exponent);
+    f = (float) (neg? -v : v);
+    return c;
+}
+
+// OBJ
+
+struct ObjChunk {
+    const char *begin, *end;
+    int nPoints = 0, nTriangles = 0;            // counted in pass 1
+    int pointOffset = 0, triangleOffset = 0;    // prefix sums
+    bool badIndex = false;
+};
+
+static inline bool IsRecord(const char *c, const char *end, char type) {
+    return c+1 < end && c[0] == type && (c[1] == ' ' || c[1] == '\t');
+}
+
+static inline bool IsFaceId(const char *c, const char *end) {
+    // a face vertex token, as ParseInt reads it: [+-]digits (then /vt/vn); shared by both
+    // passes, so the triangles counted are the triangles parsed
+    if (c < end && (*c == '-' || *c == '+'))
+        c++;
+    return c < end && IsDigit(*c);
+}
+
+static inline bool IsLineEnd(const char *c, const char *end) {
+    return c >= end || *c == '\n' || *c == '\r' || *c == '#';
+}
+
+static void CountObj(ObjChunk &chunk) {
+    for (const char *c = chunk.begin; c < chunk.end; ) {
+        c = SkipBlanks(c, chunk.end);
+        if (IsRecord(c, chunk.end, 'v'))
+            chunk.nPoints++;
+        else if (IsRecord(c, chunk.end, 'f')) {
+            int nIds = 0;
+            for (c += 2; ; nIds++) {
+                c = SkipBlanks(c, chunk.end);
+                if (!IsFaceId(c, chunk.end))
+                    break;
+                while (c < chunk.end && *c != ' ' && *c != '\t' && *c != '\n' && *c != '\r')
+                    c++;
+            }
+            if (nIds > 2)
+                chunk.nTriangles += nIds-2;
+        }
+        c = SkipLine(c, chunk.end);
+    }
+}
+
+static void ParseObj(ObjChunk &chunk, vec3 *points, int *triangles, int nPoints) {
+    vec3 *p = points+chunk.pointOffset;
+    int *t = triangles+3*chunk.triangleOffset;
+    int nPointsSoFar = chunk.pointOffset;       // for negative (relative) indices
+    for (const char *c = chunk.begin; c < chunk.end; ) {
+        c = SkipBlanks(c, chunk.end);
+        if (IsRecord(c, chunk.end, 'v')) {
+            vec3 &v = *p++;
+            c = ParseFloat(SkipBlanks(c+2, chunk.end), chunk.end, v.x);
+            c = ParseFloat(SkipBlanks(c, chunk.end), chunk.end, v.y);
+            c = ParseFloat(SkipBlanks(c, chunk.end), chunk.end, v.z);
+            nPointsSoFar++;
+        }
+        else if (IsRecord(c, chunk.end, 'f')) {
+            int first = 0, prev = 0;
+            for (int n = 0; ; n++) {
+                c = SkipBlanks(n? c : c+2, chunk.end);
+                if (!IsFaceId(c, chunk.end)) {
+                    if (!IsLineEnd(c, chunk.end))
+                        chunk.badIndex = true;  // not an id, nor end of record
+                    break;
+                }
+                int id;
+                c = ParseInt(c, chunk.end, id);
+                if (id == 0)
+                    chunk.badIndex = true;      // ids count from 1 (or back from -1)
+                id = id > 0? id-1 : nPointsSoFar+id;
+                if (id < 0 || id >= nPoints)
+                    chunk.badIndex = true;
+                while (c < chunk.end && *c != ' ' && *c != '\t' && *c != '\n' && *c != '\r')
+                    c++;                        // skip /vt/vn
+                if (n == 0)
+                    first = id;
+                else if (n > 1) {
+                    t[0] = first;
+                    t[1] = prev;
+                    t[2] = id;
+                    t += 3;
+                }
+                prev = id;
+            }
+        }
+        c = SkipLine(c, chunk.end);
+    }
+    if (t != triangles+3*(chunk.triangleOffset+chunk.nTriangles))
+        chunk.badIndex = true;                  // count and parse disagree: slots left unset
+}
+
+bool ReadObj(const char *filename, vector<vec3> &points, vector<int> &triangles, int nThreads) {
+    MappedFile file;
+    if (!file.Open(filename))
+        return Error(filename, "can't open");
+    const char *data = file.data, *end = data+file.size;
+    // split at line boundaries
+    int nChunks = (int) std::min((size_t) NThreads(nThreads), std::max((size_t) 1, file.size/(1 << 16)));
+    vector<ObjChunk> chunks(nChunks);
+    for (int i = 0; i < nChunks; i++) {
+        const char *c = data+file.size*i/nChunks;
+        chunks[i].begin = i == 0? data : std::min(SkipLine(c, end), end);
+    }
+    for (int i = 0; i < nChunks; i++)
+        chunks[i].end = i+1 < nChunks? chunks[i+1].begin : end;
+    // pass 1: count, then assign output offsets
+    Parallel(nChunks, [&](int i) { CountObj(chunks[i]); });
+    int nPoints = 0, nTriangles = 0;
+    for (ObjChunk &c : chunks) {
+        c.pointOffset = nPoints;
+        c.triangleOffset = nTriangles;
+        nPoints += c.nPoints;
+        nTriangles += c.nTriangles;
+    }
+    // pass 2: parse in place
+    points.resize(nPoints);
+    triangles.resize(3*nTriangles);
+    Parallel(nChunks, [&](int i) { ParseObj(chunks[i], points.data(), triangles.data(), nPoints); });
+    for (ObjChunk &c : chunks)
+        if (c.badIndex)
+            return Error(filename, "face refers to missing vertex");
+    return nPoints > 0;
+}
+
+// PLY
+
+enum PlyType { PlyNone, PlyInt8, PlyUInt8, PlyInt16, PlyUInt16, PlyInt32, PlyUInt32, PlyFloat32, PlyFloat64 };
+
+static const int plySize[] = {0, 1, 1, 2, 2, 4, 4, 4, 8};
+
+static PlyType ParsePlyType(const char *s) {
+    const char *names[][2] = {{"char", "int8"}, {"uchar", "uint8"}, {"short", "int16"}, {"ushort", "uint16"},
+                              {"int", "int32"}, {"uint", "uint32"}, {"float", "float32"}, {"double", "float64"}};
+    for (int i = 0; i < 8; i++)
+        if (!strcmp(s, names[i][0]) || !strcmp(s, names[i][1]))
+            return (PlyType) (i+1);
+    return PlyNone;
+}
+
+struct PlyProperty {
+    char name[64];
+    PlyType type = PlyNone, countType = PlyNone;   // countType set for lists
+};
+
+struct PlyElement {
+    char name[64];
+    int count = 0;
+    vector<PlyProperty> properties;
+    bool FixedSize() const {
+        for (const PlyProperty &p : properties)
+            if (p.countType != PlyNone)
+                return false;
+        return true;
+    }
+    int Stride() const {
+        int s = 0;
+        for (const PlyProperty &p : properties)
+            s += plySize[p.type];
+        return s;
+    }
+};
+
+static inline double PlyValue(const unsigned char *p, PlyType type, bool swap) {
+    unsigned char b[8];
+    int n = plySize[type];
+    if (swap) {
+        for (int i = 0; i < n; i++)
+            b[i] = p[n-1-i];
+        p = b;
+    }
+    switch (type) {
+        case PlyInt8:    return *(const int8_t *) p;
+        case PlyUInt8:   return *p;
+        case PlyInt16:   { int16_t v; memcpy(&v, p, 2); return v; }
+        case PlyUInt16:  { uint16_t v; memcpy(&v, p, 2); return v; }
+        case PlyInt32:   { int32_t v; memcpy(&v, p, 4); return v; }
+        case PlyUInt32:  { uint32_t v; memcpy(&v, p, 4); return v; }
+        case PlyFloat32: { float v; memcpy(&v, p, 4); return v; }
+        case PlyFloat64: { double v; memcpy(&v, p, 8); return v; }
+        default:         return 0;
+    }
+}
+
+static inline const unsigned char *SkipPlyProperty(const unsigned char *p, const unsigned char *pEnd,
+                                                   const PlyProperty &prop, bool swap) {
+    // return the next property, or NULL if this one runs past pEnd or its list count is negative
+    if (prop.countType == PlyNone)
+        return pEnd-p >= plySize[prop.type]? p+plySize[prop.type] : NULL;
+    if (pEnd-p < plySize[prop.countType])
+        return NULL;
+    double n = PlyValue(p, prop.countType, swap);
+    p += plySize[prop.countType];
+    if (n < 0 || n*plySize[prop.type] > pEnd-p)
+        return NULL;
+    return p+(size_t) n*plySize[prop.type];
+}
+
+static const unsigned char *SkipPlyRecord(const unsigned char *p, const unsigned char *pEnd, const PlyElement &e, bool swap) {
+    for (size_t k = 0; k < e.properties.size() && p; k++)
+        p = SkipPlyProperty(p, pEnd, e.properties[k], swap);
+    return p;
+}
+
+static bool ReadPlyHeader(const char *data, const char *end, vector<PlyElement> &elements,
+                          bool &bigEndian, const char *&body, const char *filename) {
+    char line[256], word[64], type[64], countType[64], itemType[64], name[64];
+    bool binary = false;
+    if (end-data < 4 || strncmp(data, "ply", 3))
+        return Error(filename, "not a PLY file");
+    for (const char *c = data; c < end; ) {
+        const char *next = SkipLine(c, end);
+        size_t len = std::min((size_t) (next-c), sizeof(line)-1);
+        memcpy(line, c, len);
+        line[len] = 0;
+        c = next;
+        if (sscanf(line, "%63s", word) != 1)
+            continue;
+        if (!strcmp(word, "format")) {
+            if (sscanf(line, "%*s %63s", type) == 1) {
+                binary = strcmp(type, "ascii") != 0;
+                bigEndian = !strcmp(type, "binary_big_endian");
+            }
+        }
+        else if (!strcmp(word, "element")) {
+            PlyElement e;
+            if (sscanf(line, "%*s %63s %d", e.name, &e.count) == 2) {
+                if (e.count < 0)
+                    return Error(filename, "negative element count");
+                elements.push_back(e);
+            }
+        }
+        else if (!strcmp(word, "property") && !elements.empty()) {
+            PlyProperty p;
+            if (sscanf(line, "%*s list %63s %63s %63s", countType, itemType, name) == 3) {
+                p.countType = ParsePlyType(countType);
+                p.type = ParsePlyType(itemType);
+            }
+            else if (sscanf(line, "%*s %63s %63s", type, name) == 2)
+                p.type = ParsePlyType(type);
+            if (p.type == PlyNone)
+                return Error(filename, "unknown property type");
+            strcpy(p.name, name);
+            elements.back().properties.push_back(p);
+        }
+        else if (!strcmp(word, "end_header")) {
+            body = c;
+            return binary? true : Error(filename, "only binary PLY is supported");
+        }
+    }
+    return Error(filename, "no end_header");
+}
+
+bool ReadPly(const char *filename, vector<vec3> &points, vector<int> &triangles, int nThreads) {
+    MappedFile file;
+    if (!file.Open(filename))
+        return Error(filename, "can't open");
+    const char *end = file.data+file.size, *body = NULL;
+    vector<PlyElement> elements;
+    bool bigEndian = false;
+    if (!ReadPlyHeader(file.data, end, elements, bigEndian, body, filename))
+        return false;
+    const unsigned char *p = (const unsigned char *) body, *pEnd = (const unsigned char *) end;
+    uint16_t one = 1;
+    bool swap = bigEndian == (*(unsigned char *) &one == 1);
+    nThreads = NThreads(nThreads);
+    points.clear();
+    triangles.clear();
+    for (const PlyElement &e : elements) {
+        if (!strcmp(e.name, "vertex")) {
+            // fixed-size records: decode x, y, z in parallel ranges
+            if (!e.FixedSize())
+                return Error(filename, "variable-size vertex records");
+            int stride = e.Stride(), offsets[3] = {-1, -1, -1}, offset = 0;
+            PlyType types[3] = {PlyNone, PlyNone, PlyNone};
+            for (const PlyProperty &prop : e.properties) {
+                for (int k = 0; k < 3; k++)
+                    if (!strcmp(prop.name, k == 0? "x" : k == 1? "y" : "z")) {
+                        offsets[k] = offset;
+                        types[k] = prop.type;
+                    }
+                offset += plySize[prop.type];
+            }
+            if (offsets[0] < 0 || offsets[1] < 0 || offsets[2] < 0)
+                return Error(filename, "vertex lacks x, y or z");
+            if (p+(size_t) stride*e.count > pEnd)
+                return Error(filename, "truncated vertex data");
+            points.resize(e.count);
+            const unsigned char *base = p;
+            int n = e.count, nParts = std::max(1, std::min(nThreads, n/4096));
+            Parallel(nParts, [&](int part) {
+                for (int i = n*part/nParts, iEnd = n*(part+1)/nParts; i < iEnd; i++) {
+                    const unsigned char *r = base+(size_t) i*stride;
+                    for (int k = 0; k < 3; k++)
+                        points[i][k] = (float) PlyValue(r+offsets[k], types[k], swap);
+                }
+            });
+            p += (size_t) stride*e.count;
+        }
+        else if (!strcmp(e.name, "face")) {
+            // variable-size records: one light sequential pass to split into blocks
+            // and count triangles per block, then parallel decode of the blocks
+            int listId = -1;
+            for (size_t i = 0; i < e.properties.size(); i++)
+                if (e.properties[i].countType != PlyNone &&
+                    (!strcmp(e.properties[i].name, "vertex_indices") || !strcmp(e.properties[i].name, "vertex_index")))
+                    listId = (int) i;
+            if (listId < 0)
+                return Error(filename, "face lacks vertex_indices");
+            int nBlocks = std::max(1, std::min(nThreads*4, e.count/4096));
+            vector<const unsigned char *> blockStart(nBlocks+1);
+            vector<int> blockTriangles(nBlocks+1, 0);
+            int nTriangles = 0;
+            for (int b = 0, i = 0; b < nBlocks; b++) {
+                blockStart[b] = p;
+                blockTriangles[b] = nTriangles;
+                for (int iEnd = (int) ((int64_t) e.count*(b+1)/nBlocks); i < iEnd; i++) {
+                    for (size_t k = 0; k < e.properties.size(); k++) {
+                        // bounds and counts are checked here, so the decode below need not
+                        const PlyProperty &prop = e.properties[k];
+                        const unsigned char *next = SkipPlyProperty(p, pEnd, prop, swap);
+                        if (!next)
+                            return Error(filename, "truncated or negative-length face data");
+                        if ((int) k == listId) {
+                            int n = (int) PlyValue(p, prop.countType, swap);
+                            nTriangles += n > 2? n-2 : 0;
+                        }
+                        p = next;
+                    }
+                }
+            }
+            blockStart[nBlocks] = p;
+            blockTriangles[nBlocks] = nTriangles;
+            triangles.resize(3*nTriangles);
+            const PlyProperty &list = e.properties[listId];
+            int nPoints = (int) points.size();
+            std::atomic<bool> badIndex(false);
+            Parallel(std::min(nThreads, nBlocks), [&](int thread) {
+                for (int b = thread; b < nBlocks; b += std::min(nThreads, nBlocks)) {
+                    int *t = triangles.data()+3*blockTriangles[b];
+                    for (const unsigned char *r = blockStart[b]; r < blockStart[b+1]; ) {
+                        for (int k = 0; k < listId; k++)
+                            r = SkipPlyProperty(r, pEnd, e.properties[k], swap);
+                        int n = (int) PlyValue(r, list.countType, swap);
+                        r += plySize[list.countType];
+                        int first = 0, prev = 0;
+                        for (int j = 0; j < n; j++, r += plySize[list.type]) {
+                            int id = (int) PlyValue(r, list.type, swap);
+                            if (id < 0 || id >= nPoints)
+                                badIndex = true;
+                            if (j == 0)
+                                first = id;
+                            else if (j > 1) {
+                                t[0] = first;
+                                t[1] = prev;
+                                t[2] = id;
+                                t += 3;
+                            }
+                            prev = id;
+                        }
+                        for (size_t k = listId+1; k < e.properties.size(); k++)
+                            r = SkipPlyProperty(r, pEnd, e.properties[k], swap);
+                    }
+                }
+            });
+            if (badIndex)
+                return Error(filename, "face refers to missing vertex");
+        }
+        else {
+            // skip other elements
+            for (int i = 0; i < e.count && p; i++)
+                p = SkipPlyRecord(p, pEnd, e, swap);
+        }
+        if (!p || p > pEnd)
+            return Error(filename, "truncated data");
+    }
+    return !points.empty();
+}
+
+// binary cache
+
+struct MeshCacheHeader {
+    char     magic[8];                          // "BMESH\0\0\0"
+    uint32_t version, byteOrder;                // byteOrder reads 0x01020304 if native
+    uint32_t nPoints, nTriangles;
+    uint64_t pointOffset, normalOffset, triangleOffset;
+    float    bbMin[3], bbMax[3];
+    uint8_t  pad[128-72];
+};
+
+static_assert(sizeof(MeshCacheHeader) == 128, "cache header layout");
+
+static const char cacheMagic[8] = {'B', 'M', 'E', 'S', 'H', 0, 0, 0};
+static const uint32_t cacheVersion = 1, cacheByteOrder = 0x01020304;
+
+static uint64_t Align64(uint64_t n) { return (n+63) & ~(uint64_t) 63; }
+
+bool WriteMeshCache(const char *filename, const vector<vec3> &points,
+                    const vector<vec3> &normals, const vector<int> &triangles) {
+    if (normals.size() != points.size())
+        return Error(filename, "need one normal per point");
+    MeshCacheHeader h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, cacheMagic, 8);
+    h.version = cacheVersion;
+    h.byteOrder = cacheByteOrder;
+    h.nPoints = (uint32_t) points.size();
+    h.nTriangles = (uint32_t) triangles.size()/3;
+    h.pointOffset = Align64(sizeof(h));
+    h.normalOffset = Align64(h.pointOffset+points.size()*sizeof(vec3));
+    h.triangleOffset = Align64(h.normalOffset+normals.size()*sizeof(vec3));
+    vec3 mn(FLT_MAX, FLT_MAX, FLT_MAX), mx(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+    for (const vec3 &p : points)
+        for (int k = 0; k < 3; k++) {
+            mn[k] = std::min(mn[k], p[k]);
+            mx[k] = std::max(mx[k], p[k]);
+        }
+    for (int k = 0; k < 3; k++) {
+        h.bbMin[k] = mn[k];
+        h.bbMax[k] = mx[k];
+    }
+    FILE *out = fopen(filename, "wb");
+    if (!out)
+        return Error(filename, "can't create");
+    char zeros[64] = {0};
+    auto Block = [&](uint64_t offset, const void *data, size_t nbytes) {
+        long at = ftell(out);
+        fwrite(zeros, 1, (size_t) (offset-at), out);
+        fwrite(data, 1, nbytes, out);
+    };
+    fwrite(&h, sizeof(h), 1, out);
+    Block(h.pointOffset, points.data(), points.size()*sizeof(vec3));
+    Block(h.normalOffset, normals.data(), normals.size()*sizeof(vec3));
+    Block(h.triangleOffset, triangles.data(), 3*(size_t) h.nTriangles*sizeof(int));
+    bool ok = !ferror(out);
+    fclose(out);
+    return ok? true : Error(filename, "write failed");
+}
+
+bool MeshCache::Open(const char *filename) {
+    Close();
+    file = new MappedFile;
+    MeshCacheHeader h;
+    if (!file->Open(filename) || file->size < sizeof(h)) {
+        Close();
+        return Error(filename, "can't open");
+    }
+    memcpy(&h, file->data, sizeof(h));
+    bool valid = !memcmp(h.magic, cacheMagic, 8) && h.version == cacheVersion && h.byteOrder == cacheByteOrder &&
+        h.pointOffset%64 == 0 && h.normalOffset%64 == 0 && h.triangleOffset%64 == 0 &&
+        h.pointOffset >= sizeof(h) && h.nPoints <= INT_MAX && h.nTriangles <= INT_MAX/3 &&
+        h.normalOffset >= h.pointOffset+(uint64_t) h.nPoints*sizeof(vec3) &&
+        h.triangleOffset >= h.normalOffset+(uint64_t) h.nPoints*sizeof(vec3) &&
+        file->size >= h.triangleOffset+3*(uint64_t) h.nTriangles*sizeof(int);
+    if (!valid) {
+        Close();
+        return Error(filename, "not a valid mesh cache (or written with a different version or byte order)");
+    }
+    // ids go to the GPU and SoftRaster unchecked: one pass here, cheap next to the upload
+    const int *ids = (const int *) (file->data+h.triangleOffset);
+    for (size_t i = 0, n = 3*(size_t) h.nTriangles; i < n; i++)
+        if (ids[i] < 0 || (uint32_t) ids[i] >= h.nPoints) {
+            Close();
+            return Error(filename, "triangle vertex id out of range");
+        }
+    nPoints = (int) h.nPoints;
+    nTriangles = (int) h.nTriangles;
+    points = (const vec3 *) (file->data+h.pointOffset);
+    normals = (const vec3 *) (file->data+h.normalOffset);
+    triangles = (const int *) (file->data+h.triangleOffset);
+    bbMin = vec3(h.bbMin[0], h.bbMin[1], h.bbMin[2]);
+    bbMax = vec3(h.bbMax[0], h.bbMax[1], h.bbMax[2]);
+    return true;
+}
+
+void MeshCache::Close() {
+    delete file;
+    file = NULL;
+    points = normals = NULL;
+    triangles = NULL;
+    nPoints = nTriangles = 0;
+}
+
+// dispatch
+
+static bool HasExtension(const char *filename, const char *ext) {
+    size_t n = strlen(filename), m = strlen(ext);
+    if (n < m)
+        return false;
+    for (size_t i = 0; i < m; i++)
+        if (tolower(filename[n-m+i]) != ext[i])
+            return false;
+    return true;
+}
+
+bool ReadMesh(const char *filename, vector<vec3> &points, vector<int> &triangles, int nThreads) {
+    if (HasExtension(filename, ".obj"))
+        return ReadObj(filename, points, triangles, nThreads);
+    if (HasExtension(filename, ".ply"))
+        return ReadPly(filename, points, triangles, nThreads);
+    return Error(filename, "unknown mesh format");
+}
+
+const char *MeshFileArg(int ac, char **av) {
+    for (int i = 1; i < ac; i++)
+        if (HasExtension(av[i], ".obj") || HasExtension(av[i], ".ply") || HasExtension(av[i], ".bmesh"))
+            return av[i];
+    return NULL;
+}
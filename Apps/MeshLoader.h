@@ -0,0 +1,65 @@
+// MeshLoader.h - memory-mapped, multi-threaded OBJ and binary PLY readers
+//
+// the file is mapped rather than read, and split into chunks parsed in parallel:
+// a first pass counts vertices and triangles per chunk, a prefix sum gives each
+// chunk its output offsets, and a second pass parses numbers in place straight
+// into the packed arrays (no per-line strings, no intermediate copies)
+// polygons are fan-triangulated; texture coordinates and file normals are ignored
+//
+// once a mesh has been read and processed (normalized, normals computed), it can be
+// saved as a binary cache (.bmesh): a header with counts, bounding box and block offsets,
+// then 64-byte aligned point, normal and index blocks in GPU-ready layout; a cache is
+// mapped, not parsed, and its point and normal blocks (contiguous but for alignment
+// padding) go to glBufferData straight from the mapping
+
+#ifndef MESH_LOADER_HDR
+#define MESH_LOADER_HDR
+
+#include <stddef.h>
+#include <vector>
+#include "VecMat.h"
+
+bool ReadObj(const char *filename, std::vector<vec3> &points, std::vector<int> &triangles, int nThreads = 0);
+    // Wavefront OBJ: 'v' and 'f' records, including v/vt/vn and negative (relative) indices
+
+bool ReadPly(const char *filename, std::vector<vec3> &points, std::vector<int> &triangles, int nThreads = 0);
+    // binary (little or big endian) PLY: float or double x, y, z; face index lists
+
+bool ReadMesh(const char *filename, std::vector<vec3> &points, std::vector<int> &triangles, int nThreads = 0);
+    // dispatch on filename extension
+    // triangles receive 3 vertex ids per triangle; nThreads 0 means one per hardware thread
+
+const char *MeshFileArg(int ac, char **av);
+    // first command-line argument naming a readable mesh format (.obj, .ply, .bmesh), or NULL
+
+// binary cache
+
+bool WriteMeshCache(const char *filename, const std::vector<vec3> &points,
+                    const std::vector<vec3> &normals, const std::vector<int> &triangles);
+    // save processed mesh; one normal per point
+
+class MappedFile;
+
+class MeshCache {
+public:
+    int nPoints = 0, nTriangles = 0;
+    const vec3 *points = NULL, *normals = NULL;
+    const int *triangles = NULL;                // 3 vertex ids per triangle
+    vec3 bbMin, bbMax;
+    bool Open(const char *filename);
+        // map file and validate header; arrays point into the mapping until Close()
+    const void *VertexData() const { return points; }
+    int VertexBytes() const { return (int) ((const char *) (normals+nPoints)-(const char *) points); }
+    int NormalOffset() const { return (int) ((const char *) normals-(const char *) points); }
+        // points and normals as one buffer: glBufferData(VertexBytes(), VertexData()),
+        // "point" attribute at offset 0, "normal" at NormalOffset()
+    void Close();
+    MeshCache() { }
+    MeshCache(const MeshCache &) = delete;
+    MeshCache &operator=(const MeshCache &) = delete;
+    ~MeshCache() { Close(); }
+private:
+    MappedFile *file = NULL;
+};
+
+#endif
@@ -0,0 +1,210 @@
+// MeshOptimize.cpp - triangle and vertex reordering for GPU cache locality and overdraw
+
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+#include "MeshOptimize.h"
+
+using std::vector;
+
+// measurement
+
+float ACMR(const int *triangles, int nTriangles, int cacheSize) {
+    if (nTriangles <= 0)
+        return 0;
+    int nPoints = 0;
+    for (int i = 0; i < 3*nTriangles; i++)
+        nPoints = std::max(nPoints, triangles[i]+1);
+    // FIFO: a vertex is cached if it entered within the last cacheSize misses
+    vector<int> entered(nPoints, -cacheSize-1);
+    int misses = 0;
+    for (int i = 0; i < 3*nTriangles; i++) {
+        int v = triangles[i];
+        if (misses-entered[v] > cacheSize)
+            entered[v] = misses++;
+    }
+    return (float) misses/nTriangles;
+}
+
+// vertex cache (Forsyth, "Linear-Speed Vertex Cache Optimisation")
+
+static const int lruSize = 32;
+
+static float VertexScore(int cachePos, int nActive) {
+    if (nActive == 0)
+        return -1;                              // no triangles left to draw
+    float score = 0;
+    if (cachePos >= 0) {
+        if (cachePos < 3)
+            score = .75f;                       // in the last triangle: fixed, to avoid strips
+        else
+            score = powf(1-(float) (cachePos-3)/(lruSize-3), 1.5f);
+    }
+    return score+2/sqrtf((float) nActive);      // favor vertices with few triangles left
+}
+
+void OptimizeVertexCache(int *triangles, int nTriangles, int nPoints) {
+    if (nTriangles <= 0)
+        return;
+    // per-vertex active triangle lists (compressed rows, shrunk as triangles are emitted)
+    vector<int> start(nPoints+1, 0), nActive(nPoints, 0), adjacent(3*nTriangles);
+    for (int i = 0; i < 3*nTriangles; i++)
+        nActive[triangles[i]]++;
+    for (int v = 0; v < nPoints; v++)
+        start[v+1] = start[v]+nActive[v];
+    vector<int> fill(start.begin(), start.end()-1);
+    for (int i = 0; i < 3*nTriangles; i++)
+        adjacent[fill[triangles[i]]++] = i/3;
+    vector<int> cachePos(nPoints, -1);
+    vector<float> vScore(nPoints), tScore(nTriangles, 0);
+    vector<char> emitted(nTriangles, 0);
+    for (int v = 0; v < nPoints; v++)
+        vScore[v] = VertexScore(-1, nActive[v]);
+    for (int t = 0; t < nTriangles; t++)
+        for (int k = 0; k < 3; k++)
+            tScore[t] += vScore[triangles[3*t+k]];
+    int best = (int) (std::max_element(tScore.begin(), tScore.end())-tScore.begin());
+    int cache[lruSize+3], cacheCount = 0, scan = 0;
+    vector<int> order(3*nTriangles);
+    for (int n = 0; n < nTriangles; n++) {
+        if (best < 0) {
+            // no candidate adjacent to the cache: resume at the next unemitted triangle
+            while (emitted[scan])
+                scan++;
+            best = scan;
+        }
+        const int *tri = triangles+3*best;
+        memcpy(&order[3*n], tri, 3*sizeof(int));
+        emitted[best] = 1;
+        // retire triangle from its vertices' active lists
+        for (int k = 0; k < 3; k++) {
+            int v = tri[k], *a = &adjacent[start[v]];
+            for (int i = 0; i < nActive[v]; i++)
+                if (a[i] == best) {
+                    a[i] = a[--nActive[v]];
+                    break;
+                }
+        }
+        // move triangle's vertices to the front of the LRU cache
+        int newCache[lruSize+3], newCount = 0;
+        for (int k = 0; k < 3; k++)
+            newCache[newCount++] = tri[k];
+        for (int i = 0; i < cacheCount; i++)
+            if (cache[i] != tri[0] && cache[i] != tri[1] && cache[i] != tri[2])
+                newCache[newCount++] = cache[i];
+        for (int i = 0; i < newCount; i++) {
+            int v = newCache[i];
+            cachePos[v] = i < lruSize? i : -1;
+            vScore[v] = VertexScore(cachePos[v], nActive[v]);
+        }
+        cacheCount = std::min(newCount, lruSize);
+        memcpy(cache, newCache, cacheCount*sizeof(int));
+        // rescore triangles touching the cache, pick the best
+        best = -1;
+        float bestScore = -1;
+        for (int i = 0; i < newCount; i++) {
+            int v = newCache[i];
+            for (int j = 0; j < nActive[v]; j++) {
+                int t = adjacent[start[v]+j];
+                const int *tv = triangles+3*t;
+                float s = tScore[t] = vScore[tv[0]]+vScore[tv[1]]+vScore[tv[2]];
+                if (s > bestScore) {
+                    bestScore = s;
+                    best = t;
+                }
+            }
+        }
+    }
+    memcpy(triangles, order.data(), 3*nTriangles*sizeof(int));
+}
+
+// overdraw
+
+void OptimizeOverdraw(int *triangles, int nTriangles, const vec3 *points, bool ccwFront, int cacheSize) {
+    if (nTriangles <= 0)
+        return;
+    int nPoints = 0;
+    for (int i = 0; i < 3*nTriangles; i++)
+        nPoints = std::max(nPoints, triangles[i]+1);
+    // cluster boundaries where a triangle misses on all three vertices (a cache restart)
+    vector<int> clusterStart;
+    vector<int> entered(nPoints, -cacheSize-1);
+    int misses = 0;
+    for (int t = 0; t < nTriangles; t++) {
+        int nMiss = 0;
+        for (int k = 0; k < 3; k++) {
+            int v = triangles[3*t+k];
+            if (misses-entered[v] > cacheSize) {
+                entered[v] = misses++;
+                nMiss++;
+            }
+        }
+        if (t == 0 || nMiss == 3)
+            clusterStart.push_back(t);
+    }
+    int nClusters = (int) clusterStart.size();
+    clusterStart.push_back(nTriangles);
+    // mesh centroid, then per-cluster area-weighted centroid and normal
+    vec3 center(0, 0, 0);
+    float area = 0;
+    vector<vec3> cCenter(nClusters), cNormal(nClusters);
+    for (int c = 0; c < nClusters; c++) {
+        vec3 sum(0, 0, 0), n(0, 0, 0);
+        float a = 0;
+        for (int t = clusterStart[c]; t < clusterStart[c+1]; t++) {
+            const int *tv = triangles+3*t;
+            vec3 p0 = points[tv[0]], p1 = points[tv[1]], p2 = points[tv[2]];
+            vec3 fn = ccwFront? cross(p1-p0, p2-p0) : cross(p2-p0, p1-p0);
+            float fa = length(fn);
+            sum += fa*(p0+p1+p2)/3;
+            n += fn;
+            a += fa;
+        }
+        cCenter[c] = a > 0? sum/a : points[triangles[3*clusterStart[c]]];
+        cNormal[c] = n;
+        center += sum;
+        area += a;
+    }
+    if (area > 0)
+        center = center/area;
+    // sort clusters by how far they face out from the center, most outward first
+    vector<float> key(nClusters);
+    vector<int> order(nClusters);
+    for (int c = 0; c < nClusters; c++) {
+        vec3 n = cNormal[c];
+        float len = length(n);
+        key[c] = len > 0? dot(cCenter[c]-center, n/len) : 0;
+        order[c] = c;
+    }
+    std::stable_sort(order.begin(), order.end(), [&](int a, int b) { return key[a] > key[b]; });
+    vector<int> sorted;
+    sorted.reserve(3*nTriangles);
+    for (int c : order)
+        sorted.insert(sorted.end(), triangles+3*clusterStart[c], triangles+3*clusterStart[c+1]);
+    memcpy(triangles, sorted.data(), 3*nTriangles*sizeof(int));
+}
+
+// vertex fetch
+
+vector<int> OptimizeVertexFetch(int *triangles, int nTriangles, int nPoints) {
+    vector<int> remap(nPoints, -1);
+    int next = 0;
+    for (int i = 0; i < 3*nTriangles; i++) {
+        int &v = triangles[i];
+        if (remap[v] < 0)
+            remap[v] = next++;
+        v = remap[v];
+    }
+    for (int i = 0; i < nPoints; i++)
+        if (remap[i] < 0)
+            remap[i] = next++;
+    return remap;
+}
+
+void OptimizeMesh(vector<vec3> &points, vector<int> &triangles, bool overdraw, bool ccwFront) {
+    int nPoints = (int) points.size(), nTriangles = (int) triangles.size()/3;
+    OptimizeVertexCache(triangles.data(), nTriangles, nPoints);
+    if (overdraw)
+        OptimizeOverdraw(triangles.data(), nTriangles, points.data(), ccwFront);
+    RemapVertices(points, OptimizeVertexFetch(triangles.data(), nTriangles, nPoints));
+}
@@ -0,0 +1,48 @@
+// MeshOptimize.h - triangle and vertex reordering for GPU cache locality and overdraw
+//
+// triangles in authoring (or scan) order revisit vertices long after they have left
+// the GPU's post-transform cache, so many vertices are shaded more than once; the
+// passes here reorder an indexed mesh without changing its shape:
+//     OptimizeVertexCache: Forsyth's greedy triangle order for an LRU cache
+//     OptimizeOverdraw:    split that order into clusters at cache restarts and sort
+//                          clusters outward-facing first, so front surfaces tend to draw first
+//     OptimizeVertexFetch: renumber vertices in first-use order for linear buffer reads
+// ACMR (average cache miss ratio: vertex shader runs per triangle, 0.5 ideal, 3 worst)
+// measures the result against a FIFO cache
+//
+// usage, before normals are computed or the vertex buffer is filled:
+//     float before = ACMR(triangles.data(), triangles.size()/3);
+//     OptimizeMesh(points, triangles);
+//     float after = ACMR(triangles.data(), triangles.size()/3);
+
+#ifndef MESH_OPTIMIZE_HDR
+#define MESH_OPTIMIZE_HDR
+
+#include <vector>
+#include "VecMat.h"
+
+float ACMR(const int *triangles, int nTriangles, int cacheSize = 16);
+    // vertex transforms per triangle for a FIFO post-transform cache of cacheSize entries
+
+void OptimizeVertexCache(int *triangles, int nTriangles, int nPoints);
+    // reorder triangles in place for post-transform cache hits
+
+void OptimizeOverdraw(int *triangles, int nTriangles, const vec3 *points, bool ccwFront = true, int cacheSize = 16);
+    // reorder clusters of an already cache-optimized list, keeping order within clusters;
+    // ccwFront: triangles whose vertices run counter-clockwise, seen from outside, face out
+    // (false if the mesh's normals are cross(p3-p2, p2-p1), as Normals.cpp computes them)
+
+std::vector<int> OptimizeVertexFetch(int *triangles, int nTriangles, int nPoints);
+    // renumber vertices in order of first use (unused vertices last), rewriting triangles;
+    // return remap, new id = remap[old id]; apply to each per-vertex array with RemapVertices
+
+template<typename T> void RemapVertices(std::vector<T> &data, const std::vector<int> &remap) {
+    std::vector<T> old(data);
+    for (size_t i = 0; i < remap.size() && i < old.size(); i++)
+        data[remap[i]] = old[i];
+}
+
+void OptimizeMesh(std::vector<vec3> &points, std::vector<int> &triangles, bool overdraw = true, bool ccwFront = true);
+    // all three passes; any other per-vertex arrays must be computed afterwards
+
+#endif
@@ -0,0 +1,248 @@
+// Normals.cpp - multi-threaded, SIMD vertex normals for indexed triangle meshes
+
+#include <stdio.h>
+#include <math.h>
+#include "Benchmark.h"
+#include "Normals.h"
+#include "Parallel.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define NORMALS_SSE
+#endif
+
+using std::vector;
+
+// adjacency
+
+void VertexNormals::Build(const int *t, int nt, int np) {
+    // counting sort of corners (3*face+k) by vertex
+    triangles = t;
+    nTriangles = nt;
+    nPoints = np;
+    cornerStart.assign(nPoints+1, 0);
+    for (int c = 0; c < 3*nTriangles; c++)
+        if (t[c] >= 0 && t[c] < nPoints)
+            cornerStart[t[c]+1]++;
+    for (int v = 0; v < nPoints; v++)
+        cornerStart[v+1] += cornerStart[v];
+    corners.resize(cornerStart[nPoints]);
+    vector<int> fill(cornerStart.begin(), cornerStart.end()-1);
+    for (int c = 0; c < 3*nTriangles; c++)
+        if (t[c] >= 0 && t[c] < nPoints)
+            corners[fill[t[c]]++] = c;
+    fx.resize(nTriangles);
+    fy.resize(nTriangles);
+    fz.resize(nTriangles);
+}
+
+// face normals
+
+static inline vec3 FaceNormal(const vec3 *points, const int *t) {
+    // same orientation as the original per-triangle loop; length is twice the area
+    vec3 p1(points[t[0]]), p2(points[t[1]]), p3(points[t[2]]);
+    return cross(p3-p2, p2-p1);
+}
+
+static void FaceNormals(const vec3 *points, const int *triangles, int begin, int end, bool unit,
+                        float *fx, float *fy, float *fz) {
+    int f = begin;
+#ifdef NORMALS_SSE
+    // four triangles per iteration: gather vertices into x, y, z lanes, cross in SIMD
+    for (; f+4 <= end; f += 4) {
+        const int *t = triangles+3*f;
+        const vec3 *a[4] = {points+t[0], points+t[3], points+t[6], points+t[9]};
+        const vec3 *b[4] = {points+t[1], points+t[4], points+t[7], points+t[10]};
+        const vec3 *c[4] = {points+t[2], points+t[5], points+t[8], points+t[11]};
+        __m128 ax = _mm_setr_ps(a[0]->x, a[1]->x, a[2]->x, a[3]->x);
+        __m128 ay = _mm_setr_ps(a[0]->y, a[1]->y, a[2]->y, a[3]->y);
+        __m128 az = _mm_setr_ps(a[0]->z, a[1]->z, a[2]->z, a[3]->z);
+        __m128 bx = _mm_setr_ps(b[0]->x, b[1]->x, b[2]->x, b[3]->x);
+        __m128 by = _mm_setr_ps(b[0]->y, b[1]->y, b[2]->y, b[3]->y);
+        __m128 bz = _mm_setr_ps(b[0]->z, b[1]->z, b[2]->z, b[3]->z);
+        __m128 cx = _mm_setr_ps(c[0]->x, c[1]->x, c[2]->x, c[3]->x);
+        __m128 cy = _mm_setr_ps(c[0]->y, c[1]->y, c[2]->y, c[3]->y);
+        __m128 cz = _mm_setr_ps(c[0]->z, c[1]->z, c[2]->z, c[3]->z);
+        // u = p3-p2, w = p2-p1, n = u x w
+        __m128 ux = _mm_sub_ps(cx, bx), uy = _mm_sub_ps(cy, by), uz = _mm_sub_ps(cz, bz);
+        __m128 wx = _mm_sub_ps(bx, ax), wy = _mm_sub_ps(by, ay), wz = _mm_sub_ps(bz, az);
+        __m128 nx = _mm_sub_ps(_mm_mul_ps(uy, wz), _mm_mul_ps(uz, wy));
+        __m128 ny = _mm_sub_ps(_mm_mul_ps(uz, wx), _mm_mul_ps(ux, wz));
+        __m128 nz = _mm_sub_ps(_mm_mul_ps(ux, wy), _mm_mul_ps(uy, wx));
+        if (unit) {
+            __m128 len2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, nx), _mm_mul_ps(ny, ny)), _mm_mul_ps(nz, nz));
+            __m128 nonzero = _mm_cmpgt_ps(len2, _mm_setzero_ps());
+            __m128 s = _mm_and_ps(nonzero, _mm_div_ps(_mm_set1_ps(1), _mm_sqrt_ps(len2)));
+            nx = _mm_mul_ps(nx, s);
+            ny = _mm_mul_ps(ny, s);
+            nz = _mm_mul_ps(nz, s);
+        }
+        _mm_storeu_ps(fx+f, nx);
+        _mm_storeu_ps(fy+f, ny);
+        _mm_storeu_ps(fz+f, nz);
+    }
+#endif
+    for (; f < end; f++) {
+        vec3 n = FaceNormal(points, triangles+3*f);
+        if (unit)
+            n = normalize(n);
+        fx[f] = n.x;
+        fy[f] = n.y;
+        fz[f] = n.z;
+    }
+}
+
+static inline float Angle(float y, float x) {
+    // atan2(y, x) for y >= 0, minimax polynomial (error ~1e-5 rad), ample for weights
+    float ax = fabsf(x), lo = y < ax? y : ax, hi = y < ax? ax : y;
+    if (hi == 0)
+        return 0;
+    float z = lo/hi, z2 = z*z;
+    float a = z*(.99997726f+z2*(-.33262347f+z2*(.19354346f+z2*(-.11643287f+z2*(.05265332f+z2*-.01172120f)))));
+    if (y > ax)
+        a = 1.5707963f-a;
+    return x < 0? 3.1415927f-a : a;
+}
+
+static void CornerAngles(const vec3 *points, const int *triangles, int begin, int end, float *weights) {
+    // angle at each corner is atan2(|a x b|, a.b), stable for thin triangles;
+    // |a x b| is the same for all three corners (twice the area)
+    for (int f = begin; f < end; f++) {
+        const int *t = triangles+3*f;
+        vec3 p0 = points[t[0]], p1 = points[t[1]], p2 = points[t[2]];
+        vec3 e0 = p1-p0, e1 = p2-p1, e2 = p0-p2;
+        float area2 = length(cross(e0, e1));
+        weights[3*f] = Angle(area2, -dot(e0, e2));
+        weights[3*f+1] = Angle(area2, -dot(e1, e0));
+        weights[3*f+2] = Angle(area2, -dot(e2, e1));
+    }
+}
+
+void VertexNormals::Compute(const vec3 *points, vec3 *normals, NormalWeight weight, int nThreads) {
+    bool angle = weight == WeightAngle;
+    if (angle)
+        cornerWeight.resize(3*nTriangles);
+    // pass 1: face normals (unit unless area-weighted), parallel over triangles
+    ParallelRanges(nTriangles, nThreads, 16384, [&](int begin, int end) {
+        FaceNormals(points, triangles, begin, end, weight != WeightArea, fx.data(), fy.data(), fz.data());
+        if (angle)
+            CornerAngles(points, triangles, begin, end, cornerWeight.data());
+    });
+    // pass 2: each vertex gathers from its corners, parallel over vertices (no shared writes)
+    ParallelRanges(nPoints, nThreads, 16384, [&](int begin, int end) {
+        const int *c = corners.data();
+        for (int v = begin; v < end; v++) {
+            float x = 0, y = 0, z = 0;
+            for (int i = cornerStart[v]; i < cornerStart[v+1]; i++) {
+                int f = c[i]/3;
+                float w = angle? cornerWeight[c[i]] : 1;
+                x += w*fx[f];
+                y += w*fy[f];
+                z += w*fz[f];
+            }
+            normals[v] = normalize(vec3(x, y, z));
+        }
+    });
+}
+
+// creases
+
+static int Find(vector<int> &parent, int i) {
+    while (parent[i] != i)
+        i = parent[i] = parent[parent[i]];
+    return i;
+}
+
+int SplitCreases(vector<vec3> &points, vector<int> &triangles, float creaseDegrees, vector<int> *sourcePoint) {
+    int nPoints = (int) points.size(), nTriangles = (int) triangles.size()/3;
+    vector<int> original(triangles);                    // edge tests use the unsplit topology
+    VertexNormals adjacency;
+    adjacency.Build(original.data(), nTriangles, nPoints);
+    vector<vec3> faceNormals(nTriangles);
+    for (int f = 0; f < nTriangles; f++)
+        faceNormals[f] = normalize(FaceNormal(points.data(), original.data()+3*f));
+    float cosCrease = cosf(creaseDegrees*3.1415926f/180);
+    if (sourcePoint) {
+        sourcePoint->resize(nPoints);
+        for (int i = 0; i < nPoints; i++)
+            (*sourcePoint)[i] = i;
+    }
+    vector<int> parent, group;
+    for (int v = 0; v < nPoints; v++) {
+        // union incident faces that share an edge through v and meet below the crease angle
+        const int *c = adjacency.corners.data()+adjacency.cornerStart[v];
+        int n = adjacency.cornerStart[v+1]-adjacency.cornerStart[v];
+        parent.resize(n);
+        for (int i = 0; i < n; i++)
+            parent[i] = i;
+        for (int i = 0; i < n; i++)
+            for (int j = i+1; j < n; j++) {
+                int fi = c[i]/3, fj = c[j]/3;
+                const int *ti = &original[3*fi], *tj = &original[3*fj];
+                int ui = ti[(c[i]+1)%3], wi = ti[(c[i]+2)%3];
+                int uj = tj[(c[j]+1)%3], wj = tj[(c[j]+2)%3];
+                bool shareEdge = ui == uj || ui == wj || wi == uj || wi == wj;
+                if (shareEdge && dot(faceNormals[fi], faceNormals[fj]) >= cosCrease)
+                    parent[Find(parent, i)] = Find(parent, j);
+            }
+        // first group keeps v, each other group gets a copy of the point
+        group.assign(n, -1);
+        int root0 = n? Find(parent, 0) : -1;
+        for (int i = 0; i < n; i++) {
+            int r = Find(parent, i);
+            if (r != root0 && group[r] < 0) {
+                group[r] = (int) points.size();
+                points.push_back(points[v]);
+                if (sourcePoint)
+                    sourcePoint->push_back(v);
+            }
+            if (r != root0)
+                triangles[c[i]] = group[r];
+        }
+    }
+    return (int) points.size()-nPoints;
+}
+
+// reference and benchmark
+
+void SerialNormals(const vec3 *points, const int *triangles, int nTriangles, vec3 *normals, int nPoints) {
+    for (int i = 0; i < nPoints; i++)
+        normals[i] = vec3(0, 0, 0);
+    for (int i = 0; i < nTriangles; i++) {
+        const int *t = triangles+3*i;
+        vec3 n = normalize(FaceNormal(points, t));
+        for (int k = 0; k < 3; k++)
+            normals[t[k]] += n;
+    }
+    for (int i = 0; i < nPoints; i++)
+        normals[i] = normalize(normals[i]);
+}
+
+void BenchmarkNormals(const vector<vec3> &points, const vector<int> &triangles, int nRuns) {
+    int nPoints = (int) points.size(), nTriangles = (int) triangles.size()/3;
+    vector<vec3> reference(nPoints), normals(nPoints);
+    VertexNormals vn;
+    float serial = MinTime(nRuns, [&]() { SerialNormals(points.data(), triangles.data(), nTriangles, reference.data(), nPoints); });
+    float build = MinTime(1, [&]() { vn.Build(triangles.data(), nTriangles, nPoints); });
+    float times[3];
+    const char *names[] = {"uniform", "area", "angle"};
+    for (int w = 0; w < 3; w++)
+        times[w] = MinTime(nRuns, [&]() { vn.Compute(points.data(), normals.data(), (NormalWeight) w); });
+    // uniform weighting should match the reference loop (up to summation order)
+    vn.Compute(points.data(), normals.data(), WeightUniform);
+    float maxErr = 0;
+    for (int i = 0; i < nPoints; i++) {
+        float e = length(normals[i]-reference[i]);
+        maxErr = e > maxErr? e : maxErr;
+    }
+    printf("{\n  \"points\": %d,\n  \"triangles\": %d,\n  \"threads\": %d,\n", nPoints, nTriangles, NThreads());
+#ifdef NORMALS_SSE
+    printf("  \"simd\": \"sse2\",\n");
+#else
+    printf("  \"simd\": \"none\",\n");
+#endif
+    printf("  \"serial_ms\": %.3f,\n  \"build_ms\": %.3f,\n", serial, build);
+    for (int w = 0; w < 3; w++)
+        printf("  \"%s_ms\": %.3f,\n  \"%s_speedup\": %.2f,\n", names[w], times[w], names[w], serial/times[w]);
+    printf("  \"max_uniform_error\": %g\n}\n", maxErr);
+}
@@ -0,0 +1,51 @@
+// Normals.h - multi-threaded, SIMD vertex normals for indexed triangle meshes
+//
+// a serial loop that scatters face normals into normals[t[k]] cannot be split
+// across threads without races; here the mesh's vertex-to-corner adjacency is
+// built once per topology, after which each frame:
+//     1. face normals (cross products, 4 triangles per SSE op) in parallel ranges of triangles
+//     2. each vertex gathers from its incident faces, in parallel ranges of vertices
+// so no two threads write the same output, and animated points cost two parallel passes
+//
+// usage:
+//     VertexNormals vn;
+//     vn.Build(triangles.data(), triangles.size()/3, points.size());   // once per topology
+//     vn.Compute(points.data(), normals.data(), WeightArea);           // per frame
+
+#ifndef NORMALS_HDR
+#define NORMALS_HDR
+
+#include <vector>
+#include "VecMat.h"
+
+enum NormalWeight { WeightUniform, WeightArea, WeightAngle };
+    // per-face contribution to a vertex normal: equal, by triangle area, or by corner angle
+
+class VertexNormals {
+public:
+    void Build(const int *triangles, int nTriangles, int nPoints);
+        // vertex-to-corner adjacency (compressed rows); triangles must outlive this object
+    void Compute(const vec3 *points, vec3 *normals, NormalWeight weight = WeightArea, int nThreads = 0);
+        // one unit normal per point; nThreads 0 means one per hardware thread
+private:
+    friend int SplitCreases(std::vector<vec3> &, std::vector<int> &, float, std::vector<int> *);
+    const int *triangles = 0;
+    int nTriangles = 0, nPoints = 0;
+    std::vector<int> cornerStart, corners;      // corners of vertex v: corners[cornerStart[v]..cornerStart[v+1])
+    std::vector<float> fx, fy, fz, cornerWeight;    // face normals (SoA), per-corner weights
+};
+
+int SplitCreases(std::vector<vec3> &points, std::vector<int> &triangles, float creaseDegrees,
+                 std::vector<int> *sourcePoint = 0);
+    // duplicate vertices whose incident faces meet across an edge at more than creaseDegrees,
+    // so each side of a crease gets its own normal; triangles are re-indexed in place
+    // sourcePoint, if non-null, receives the original point for each (possibly new) point,
+    // to copy animated positions into the split mesh; return number of points added
+
+void SerialNormals(const vec3 *points, const int *triangles, int nTriangles, vec3 *normals, int nPoints);
+    // reference: single-threaded scatter of unit face normals (WeightUniform)
+
+void BenchmarkNormals(const std::vector<vec3> &points, const std::vector<int> &triangles, int nRuns = 10);
+    // time SerialNormals against VertexNormals (each weighting) on the given mesh, print JSON
+
+#endif
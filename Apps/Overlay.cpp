@@ -0,0 +1,135 @@
+// Overlay.cpp - batched lines and disks, drawn with one instanced call
+
+#include <stddef.h>
+#include "CameraBlock.h"
+#include "GLXtras.h"
+#include "Overlay.h"
+#include "ProgramCache.h"
+#include "Uniforms.h"
+
+// per-instance attributes at fixed locations; corner of the quad from gl_VertexID
+static const char *vShaderCode = R"(
+    #version 330
+    layout (location = 0) in vec4 p1;
+    layout (location = 1) in vec4 p2;
+    layout (location = 2) in vec4 col1;
+    layout (location = 3) in vec3 col2;
+    out vec4 vColor;
+    out vec2 vOffset;                       // pixels from line center or disk center
+    flat out float vHalf, vDisk;            // half width or radius (pixels), primitive type
+    layout (std140, row_major) uniform Camera { mat4 modelview, persp, fullview; };
+    uniform vec2 viewport;
+    void main() {
+        vec2 corner = vec2(gl_VertexID%2 == 0? -1 : 1, gl_VertexID < 2? -1 : 1);
+        vHalf = .5*p2.w;
+        vDisk = p1.w;
+        float reach = vHalf+.5;             // extra half pixel for the antialiased rim
+        vec4 c1 = fullview*vec4(p1.xyz, 1);
+        if (p1.w > .5) {
+            // disk: square about the projected center
+            vOffset = reach*corner;
+            vColor = col1;
+            gl_Position = c1+vec4(2*vOffset/viewport*c1.w, 0, 0);
+            return;
+        }
+        // line: quad about the projected segment, perpendicular in screen space
+        vec4 c2 = fullview*vec4(p2.xyz, 1);
+        vec2 s1 = c1.xy/c1.w*viewport, s2 = c2.xy/c2.w*viewport;
+        vec2 d = s2-s1, dir = dot(d, d) > 0? normalize(d) : vec2(1, 0), n = vec2(-dir.y, dir.x);
+        vec4 c = corner.x < 0? c1 : c2;
+        vOffset = vec2(0, reach*corner.y);
+        vColor = vec4(corner.x < 0? col1.rgb : col2, col1.a);
+        gl_Position = c+vec4(2*vOffset.y*n/viewport*c.w, 0, 0);
+    }
+)";
+
+static const char *pShaderCode = R"(
+    #version 330
+    in vec4 vColor;
+    in vec2 vOffset;
+    flat in float vHalf, vDisk;
+    out vec4 pColor;
+    void main() {
+        float dist = vDisk > .5? length(vOffset) : abs(vOffset.y);
+        float coverage = clamp(vHalf-dist+.5, 0, 1);
+        if (coverage <= 0)
+            discard;
+        pColor = vec4(vColor.rgb, vColor.a*coverage);
+    }
+)";
+
+void Overlay::Line(vec3 p1, vec3 p2, float width, vec3 col, float opacity) {
+    Line(p1, p2, width, col, col, opacity);
+}
+
+void Overlay::Line(vec3 p1, vec3 p2, float width, vec3 col1, vec3 col2, float opacity) {
+    instances.push_back({vec4(p1, 0), vec4(p2, width), vec4(col1, opacity), col2});
+}
+
+void Overlay::Disk(vec3 p, float diameter, vec3 color, float opacity) {
+    instances.push_back({vec4(p, 1), vec4(p, diameter), vec4(color, opacity), color});
+}
+
+void Overlay::Init() {
+    program = LinkProgramViaCache(&vShaderCode, &pShaderCode);
+    CacheLocations(program);
+    BindCameraBlock(program);
+    glGenVertexArrays(1, &vao);
+    glGenBuffers(1, &buffer);
+    glBindVertexArray(vao);
+    glBindBuffer(GL_ARRAY_BUFFER, buffer);
+    // one record per instance, none per vertex
+    struct { int size; size_t offset; } attribs[] = {
+        {4, offsetof(Instance, p1)}, {4, offsetof(Instance, p2)},
+        {4, offsetof(Instance, col1)}, {3, offsetof(Instance, col2)}};
+    for (int i = 0; i < 4; i++) {
+        glEnableVertexAttribArray(i);
+        glVertexAttribPointer(i, attribs[i].size, GL_FLOAT, GL_FALSE, sizeof(Instance), (void *) attribs[i].offset);
+        glVertexAttribDivisor(i, 1);
+    }
+    glBindVertexArray(0);
+}
+
+void Overlay::Flush() {
+    int n = (int) instances.size();
+    if (!n)
+        return;
+    if (!program)
+        Init();
+    glBindBuffer(GL_ARRAY_BUFFER, buffer);
+    if (n > capacity)
+        capacity = n > 2*capacity? n : 2*capacity;
+    // grow geometrically; otherwise orphan the previous frame's storage, so the
+    // upload need not wait for the GPU to finish drawing from it
+    glBufferData(GL_ARRAY_BUFFER, capacity*sizeof(Instance), NULL, GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, n*sizeof(Instance), instances.data());
+    GLint vp[4];
+    glGetIntegerv(GL_VIEWPORT, vp);
+    vec2 viewport((float) vp[2], (float) vp[3]);
+    glUseProgram(program);
+    // the viewport persists in the program, so is only sent after a resize
+    if (!sent || viewport.x != sentViewport.x || viewport.y != sentViewport.y) {
+        SetUniform(UniformLocation(program, "viewport"), viewport);
+        sentViewport = viewport;
+        sent = true;
+    }
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glBindVertexArray(vao);
+    glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, n);
+    glBindVertexArray(0);
+    instances.clear();
+}
+
+void Overlay::Release() {
+    if (buffer)
+        glDeleteBuffers(1, &buffer);
+    if (vao)
+        glDeleteVertexArrays(1, &vao);
+    if (program)
+        glDeleteProgram(program);
+    ForgetLocations(program);
+    buffer = vao = program = 0;
+    capacity = 0;
+    sent = false;
+}
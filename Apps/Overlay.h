@@ -0,0 +1,55 @@
+// Overlay.h - batched lines and disks, drawn with one instanced call
+//
+// Draw.h's Line() and Disk() upload vertices and issue a draw per primitive, so a
+// control mesh or a finely segmented curve costs dozens of draws a frame; here
+// primitives are recorded into an array of per-instance records (end points,
+// colors, opacity, width or diameter) that Flush() streams into one buffer and draws
+// as a single instanced triangle strip, each instance expanded to a screen-aligned
+// quad in the vertex shader (lines are width pixels wide, disks diameter pixels across,
+// with antialiased rims); primitives draw in the order recorded
+//
+// usage:
+//     Overlay overlay;
+//     overlay.Line(p1, p2, 2, vec3(1, 1, 0));
+//     overlay.Disk(p, 7, vec3(1, 0, 0));
+//     UpdateCameraBlock(camera);
+//     overlay.Flush();                        // once per frame, after the scene
+//
+// the vertex shader reads fullview from the shared Camera block (CameraBlock.h),
+// so only the viewport is kept as a uniform of its own
+
+#ifndef OVERLAY_HDR
+#define OVERLAY_HDR
+
+#include <glad.h>
+#include <vector>
+#include "VecMat.h"
+
+class Overlay {
+public:
+    void Line(vec3 p1, vec3 p2, float width, vec3 col, float opacity = 1);
+    void Line(vec3 p1, vec3 p2, float width, vec3 col1, vec3 col2, float opacity = 1);
+        // as Draw.h: width in pixels, color interpolated from col1 to col2
+    void Disk(vec3 p, float diameter, vec3 color, float opacity = 1);
+        // diameter in pixels
+    int Count() const { return (int) instances.size(); }
+    void Flush();
+        // draw everything recorded (one draw call) with the Camera block's fullview, and
+        // clear; leaves the overlay program in use
+    void Release();
+        // delete GL objects
+private:
+    struct Instance {
+        vec4 p1, p2;            // p1.w: 0 for line, 1 for disk; p2.w: width or diameter
+        vec4 col1;              // col1.w: opacity
+        vec3 col2;
+    };
+    std::vector<Instance> instances;
+    GLuint program = 0, vao = 0, buffer = 0;
+    int capacity = 0;           // buffer size, in instances
+    bool sent = false;          // viewport sent since the program was linked
+    vec2 sentViewport;          // as last sent; re-sent only when changed
+    void Init();
+};
+
+#endif
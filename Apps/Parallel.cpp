@@ -0,0 +1,88 @@
+// Parallel.cpp - persistent job pool
+
+#include <chrono>
+#include "Parallel.h"
+
+JobPool::JobPool(int nThreads) {
+    for (int i = 1; i < ::NThreads(nThreads); i++)
+        workers.emplace_back(&JobPool::Worker, this);
+}
+
+JobPool::~JobPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        quit = true;
+    }
+    wake.notify_all();
+    for (std::thread &t : workers)
+        t.join();
+}
+
+void JobPool::Work(const std::function<void(int)> *f, int n, uint32_t g) {
+    // claim jobs of generation g until none remain; a worker that wakes late, after Run()
+    // has returned or a later Run() has begun, finds another generation and claims nothing
+    uint64_t c = next.load();
+    while ((uint32_t) (c >> 32) == g && (int) (uint32_t) c < n)
+        if (next.compare_exchange_weak(c, c+1))
+            (*f)((int) (uint32_t) c);
+}
+
+void JobPool::Worker() {
+    uint32_t seen = 0;
+    for (;;) {
+        const std::function<void(int)> *f;
+        int n;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [&]() { return quit || generation != seen; });
+            if (quit)
+                return;
+            f = job;
+            n = nJobs;
+            seen = generation;
+            busy++;
+        }
+        Work(f, n, seen);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (--busy == 0)
+                done.notify_all();
+        }
+    }
+}
+
+void JobPool::Run(int n, const std::function<void(int)> &f) {
+    if (n <= 0)
+        return;
+    uint32_t g;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        job = &f;
+        nJobs = n;
+        g = ++generation;
+        next = (uint64_t) g << 32;
+    }
+    wake.notify_all();
+    Work(&f, n, g);
+    // wait for workers still finishing a job
+    std::unique_lock<std::mutex> lock(mutex);
+    done.wait(lock, [&]() { return busy == 0; });
+}
+
+int StressJobPool(int nThreads, int nRounds) {
+    JobPool pool(nThreads);
+    const int counts[] = {1, 64, 3, 1080, 1, 510};
+    std::vector<std::atomic<int>> runs(1080);
+    int nWrong = 0;
+    for (int r = 0; r < nRounds; r++) {
+        int n = counts[r%6];
+        for (int i = 0; i < n; i++)
+            runs[i] = 0;
+        pool.Run(n, [&runs](int i) { runs[i]++; });
+        for (int i = 0; i < n; i++)
+            nWrong += runs[i] != 1;
+        if (r%3 == 0)
+            std::this_thread::sleep_for(std::chrono::microseconds(20));
+    }
+    return nWrong;
+}
@@ -0,0 +1,65 @@
+// Parallel.h - fork-join helpers for the CPU-side mesh modules
+//
+// Parallel() and ParallelRanges() start threads per call, fine for one-time work
+// such as loading; JobPool keeps its workers, for work repeated every frame
+// (eg, re-tessellating patches), so each Run() costs a wake-up, not thread creation
+
+#ifndef PARALLEL_HDR
+#define PARALLEL_HDR
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <stdint.h>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+inline int NThreads(int nThreads = 0) {
+    // nThreads if positive, else one per hardware thread
+    return nThreads > 0? nThreads : std::max(1, (int) std::thread::hardware_concurrency());
+}
+
+template<typename F> void Parallel(int n, F f) {
+    // call f(i) for i in [0, n), each on its own thread (i == 0 on the caller's)
+    std::vector<std::thread> threads;
+    for (int i = 1; i < n; i++)
+        threads.emplace_back(f, i);
+    f(0);
+    for (std::thread &t : threads)
+        t.join();
+}
+
+template<typename F> void ParallelRanges(int count, int nThreads, int grain, F f) {
+    // call f(begin, end) over contiguous ranges of [0, count), at least grain items per range
+    int n = std::max(1, std::min(NThreads(nThreads), count/std::max(1, grain)));
+    Parallel(n, [&](int i) { f((int) ((long long) count*i/n), (int) ((long long) count*(i+1)/n)); });
+}
+
+class JobPool {
+public:
+    JobPool(int nThreads = 0);
+        // nThreads-1 workers (the caller of Run is the last); 0 means one per hardware thread
+    ~JobPool();
+    int NThreads() const { return (int) workers.size()+1; }
+    void Run(int nJobs, const std::function<void(int)> &job);
+        // call job(i) for i in [0, nJobs), load-balanced across threads; return when all are done
+private:
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable wake, done;
+    const std::function<void(int)> *job = NULL;     // job, nJobs, generation: read under mutex
+    int nJobs = 0, busy = 0;
+    uint32_t generation = 0;
+    std::atomic<uint64_t> next{0};                  // generation << 32 | next job index
+    bool quit = false;
+    void Work(const std::function<void(int)> *job, int nJobs, uint32_t generation);
+    void Worker();
+};
+
+int StressJobPool(int nThreads = 0, int nRounds = 4000);
+    // Run() nRounds times, alternating job counts (as SoftRaster does within a frame) with
+    // pauses that let workers wake late; return the number of jobs not run exactly once
+
+#endif
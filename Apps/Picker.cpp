@@ -0,0 +1,86 @@
+// Picker.cpp - nearest-handle picking through a screen-space grid
+
+#include <glad.h>
+#include <math.h>
+#include <string.h>
+#include "Picker.h"
+
+void PointPicker::Add(vec3 *p, int n) {
+    for (int i = 0; i < n; i++)
+        handles.push_back(p+i);
+    dirty = true;
+}
+
+void PointPicker::Clear() {
+    handles.clear();
+    dirty = true;
+}
+
+void PointPicker::Update(const mat4 &fullview) {
+    // reproject only if handles moved or the view, viewport or radius changed
+    GLint vp[4];
+    glGetIntegerv(GL_VIEWPORT, vp);
+    int size = radius > 1? radius : 1;
+    if (!dirty && vp[2] == width && vp[3] == height && size == cellSize && !memcmp(&view, &fullview, sizeof(mat4)))
+        return;
+    view = fullview;
+    width = vp[2];
+    height = vp[3];
+    dirty = false;
+    // grid of cells radius wide, with a border of one cell so handles just
+    // off screen remain pickable
+    cellSize = size;
+    nx = width/cellSize+3;
+    ny = height/cellSize+3;
+    int n = (int) handles.size(), nCells = nx*ny;
+    screen.resize(n);
+    depth.resize(n);
+    std::vector<int> cell(n, -1);
+    cellStart.assign(nCells+1, 0);
+    for (int i = 0; i < n; i++) {
+        vec4 c = view*vec4(*handles[i], 1);
+        if (c.w <= 0)
+            continue;
+        screen[i] = vec2(vp[0]+(c.x/c.w+1)*.5f*width, vp[1]+(c.y/c.w+1)*.5f*height);
+        depth[i] = c.z/c.w;
+        int cx = (int) ((screen[i].x-vp[0])/cellSize+1), cy = (int) ((screen[i].y-vp[1])/cellSize+1);
+        if (screen[i].x+cellSize >= vp[0] && screen[i].y+cellSize >= vp[1] && cx < nx && cy < ny) {
+            cell[i] = cy*nx+cx;
+            cellStart[cell[i]+1]++;
+        }
+    }
+    // counting sort of handle ids by cell
+    for (int c = 0; c < nCells; c++)
+        cellStart[c+1] += cellStart[c];
+    cellIds.resize(cellStart[nCells]);
+    std::vector<int> fill(cellStart.begin(), cellStart.end()-1);
+    for (int i = 0; i < n; i++)
+        if (cell[i] >= 0)
+            cellIds[fill[cell[i]]++] = i;
+}
+
+vec3 *PointPicker::Pick(int x, int y, const mat4 &fullview, float *dist) {
+    Update(fullview);
+    GLint vp[4];
+    glGetIntegerv(GL_VIEWPORT, vp);
+    int qx = (int) ((float) (x-vp[0])/cellSize+1), qy = (int) ((float) (y-vp[1])/cellSize+1);
+    int best = -1;
+    float bestD2 = (float) radius*radius;
+    // radius <= cellSize, so any handle in range lies in the 3x3 cells around the cursor
+    for (int cy = qy-1; cy <= qy+1; cy++)
+        for (int cx = qx-1; cx <= qx+1; cx++) {
+            if (cx < 0 || cy < 0 || cx >= nx || cy >= ny)
+                continue;
+            for (int k = cellStart[cy*nx+cx]; k < cellStart[cy*nx+cx+1]; k++) {
+                int i = cellIds[k];
+                float dx = screen[i].x-x, dy = screen[i].y-y, d2 = dx*dx+dy*dy;
+                if (d2 < bestD2 || (d2 == bestD2 && best >= 0 && depth[i] < depth[best])) {
+                    best = i;
+                    bestD2 = d2;
+                }
+            }
+        }
+    if (dist)
+        *dist = best >= 0? sqrtf(bestD2) : -1;
+    return best >= 0? handles[best] : NULL;
+}
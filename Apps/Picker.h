@@ -0,0 +1,44 @@
+// Picker.h - nearest-handle picking through a screen-space grid
+//
+// calling MouseOver() or ScreenDistSq() on every handle transforms each one per
+// query, and taking the first within range can select a farther handle than the
+// nearest; here the handles are projected once, when the view (or a handle) has
+// changed, and bucketed into a grid of screen cells no smaller than the pick radius,
+// so a pick examines only the 3x3 cells around the cursor and returns the nearest
+//
+// usage:
+//     PointPicker picker;
+//     picker.Add(&ctrlPts[0][0], 16);                     // handles must outlive the picker
+//     vec3 *p = picker.Pick(x, y, camera.fullview);       // on mouse down, y upward
+//     picker.Moved();                                     // after dragging a handle
+
+#ifndef PICKER_HDR
+#define PICKER_HDR
+
+#include <vector>
+#include "VecMat.h"
+
+class PointPicker {
+public:
+    int radius = 12;                        // pick distance, in pixels
+    void Add(vec3 *p, int n = 1);
+        // register n contiguous handles
+    void Clear();
+    int Size() const { return (int) handles.size(); }
+    void Moved() { dirty = true; }
+        // handles changed: reproject at the next pick
+    vec3 *Pick(int x, int y, const mat4 &fullview, float *dist = 0);
+        // nearest handle to screen (x, y) (upward y, as MouseOver) within radius, else NULL
+        // (ties go to the handle nearer the eye); optionally set its distance in pixels
+private:
+    std::vector<vec3 *> handles;
+    std::vector<vec2> screen;               // projected handles (x < 0 if behind the eye)
+    std::vector<float> depth;
+    std::vector<int> cellStart, cellIds;    // handles in cell c: cellIds[cellStart[c]..cellStart[c+1])
+    int nx = 0, ny = 0, cellSize = 0, width = 0, height = 0;
+    mat4 view;
+    bool dirty = true;
+    void Update(const mat4 &fullview);
+};
+
+#endif
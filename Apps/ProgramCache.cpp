@@ -0,0 +1,185 @@
+// ProgramCache.cpp - shader programs compiled once, then reloaded as driver binaries
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#ifdef _WIN32
+    #include <direct.h>
+#else
+    #include <sys/stat.h>
+#endif
+#include "GLXtras.h"
+#include "ProgramCache.h"
+
+using std::string;
+using std::vector;
+
+const char *programCacheDir = "ProgramCache";
+
+struct ProgramCacheHeader {
+    char     magic[8];                          // "GLPROG\0\0"
+    uint64_t key;                               // as in the file name
+    uint32_t format, length;                    // driver binary format, bytes following header
+};
+
+static_assert(sizeof(ProgramCacheHeader) == 24, "program cache header layout");
+
+static const char programMagic[8] = {'G', 'L', 'P', 'R', 'O', 'G', 0, 0};
+static const int nStages = 5;
+
+// key
+
+static uint64_t Hash(uint64_t h, const char *s) {
+    // FNV-1a, including the terminator so that adjacent strings cannot run together
+    do
+        h = (h^(uint8_t) *s)*0x100000001b3ull;
+    while (*s++);
+    return h;
+}
+
+static uint64_t Key(const char **codes[nStages]) {
+    uint64_t h = 0xcbf29ce484222325ull;
+    GLenum ids[] = {GL_VENDOR, GL_RENDERER, GL_VERSION};
+    for (GLenum id : ids) {
+        const char *s = (const char *) glGetString(id);
+        h = Hash(h, s? s : "");
+    }
+    for (int i = 0; i < nStages; i++)
+        h = Hash(h, codes[i] && *codes[i]? *codes[i] : "");
+    return h;
+}
+
+static string FileName(uint64_t key) {
+    char name[32];
+    snprintf(name, sizeof(name), "/%016llx.bin", (unsigned long long) key);
+    return string(programCacheDir)+name;
+}
+
+// load and save
+
+static bool FormatSupported(GLenum format) {
+    GLint n = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &n);
+    vector<GLint> formats(n > 0? n : 1);
+    if (n > 0)
+        glGetIntegerv(GL_PROGRAM_BINARY_FORMATS, formats.data());
+    for (int i = 0; i < n; i++)
+        if ((GLenum) formats[i] == format)
+            return true;
+    return false;
+}
+
+static GLuint Load(const string &filename, uint64_t key) {
+    FILE *in = fopen(filename.c_str(), "rb");
+    if (!in)
+        return 0;
+    ProgramCacheHeader h;
+    vector<char> data;
+    bool ok = fread(&h, sizeof(h), 1, in) == 1 && !memcmp(h.magic, programMagic, 8) && h.key == key && h.length;
+    if (ok) {
+        data.resize(h.length);
+        ok = fread(data.data(), 1, h.length, in) == h.length;
+    }
+    fclose(in);
+    // a binary from an older driver may be refused: a format no longer offered, or a failed link
+    if (!ok || !FormatSupported(h.format))
+        return 0;
+    GLuint program = glCreateProgram();
+    glProgramBinary(program, h.format, data.data(), (GLsizei) h.length);
+    GLint linked = 0;
+    glGetProgramiv(program, GL_LINK_STATUS, &linked);
+    if (!linked) {
+        glDeleteProgram(program);
+        return 0;
+    }
+    return program;
+}
+
+static void Save(const string &filename, uint64_t key, GLuint program) {
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0)
+        return;
+    vector<char> data(length);
+    GLenum format = 0;
+    glGetProgramBinary(program, length, &length, &format, data.data());
+#ifdef _WIN32
+    _mkdir(programCacheDir);
+#else
+    mkdir(programCacheDir, 0755);
+#endif
+    FILE *out = fopen(filename.c_str(), "wb");
+    if (!out)
+        return;
+    ProgramCacheHeader h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, programMagic, 8);
+    h.key = key;
+    h.format = format;
+    h.length = (uint32_t) length;
+    fwrite(&h, sizeof(h), 1, out);
+    fwrite(data.data(), 1, length, out);
+    bool ok = !ferror(out);
+    fclose(out);
+    if (!ok)
+        remove(filename.c_str());               // a truncated binary would fail its next load
+}
+
+// compile
+
+static GLuint Compile(const char **codes[nStages]) {
+    // as LinkProgramViaCode, but retrievable: the hint must precede the link
+    static const GLenum types[nStages] = {GL_VERTEX_SHADER, GL_TESS_CONTROL_SHADER,
+        GL_TESS_EVALUATION_SHADER, GL_GEOMETRY_SHADER, GL_FRAGMENT_SHADER};
+    GLuint program = glCreateProgram(), shaders[nStages] = {0};
+    GLint ok = 1;
+    for (int i = 0; i < nStages && ok; i++)
+        if (codes[i] && *codes[i]) {
+            shaders[i] = glCreateShader(types[i]);
+            glShaderSource(shaders[i], 1, codes[i], NULL);
+            glCompileShader(shaders[i]);
+            glGetShaderiv(shaders[i], GL_COMPILE_STATUS, &ok);
+            glAttachShader(program, shaders[i]);
+        }
+    if (ok) {
+        glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+        glLinkProgram(program);
+        glGetProgramiv(program, GL_LINK_STATUS, &ok);
+    }
+    for (int i = 0; i < nStages; i++)
+        if (shaders[i]) {
+            glDetachShader(program, shaders[i]);
+            glDeleteShader(shaders[i]);
+        }
+    if (!ok) {
+        glDeleteProgram(program);
+        return 0;
+    }
+    return program;
+}
+
+// link
+
+GLuint LinkProgramViaCache(const char **vCode, const char **tcCode, const char **teCode,
+                           const char **gCode, const char **pCode) {
+    GLint nFormats = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &nFormats);
+    if (!programCacheDir || nFormats <= 0)
+        return LinkProgramViaCode(vCode, tcCode, teCode, gCode, pCode);
+    const char **codes[nStages] = {vCode, tcCode, teCode, gCode, pCode};
+    uint64_t key = Key(codes);
+    string filename = FileName(key);
+    GLuint program = Load(filename, key);
+    if (program)
+        return program;
+    if (!(program = Compile(codes)))
+        return LinkProgramViaCode(vCode, tcCode, teCode, gCode, pCode);   // for its error messages
+    Save(filename, key, program);
+    return program;
+}
+
+GLuint LinkProgramViaCache(const char **vCode, const char **pCode) {
+    return LinkProgramViaCache(vCode, NULL, NULL, NULL, pCode);
+}
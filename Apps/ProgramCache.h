@@ -0,0 +1,27 @@
+// ProgramCache.h - shader programs compiled once, then reloaded as driver binaries
+//
+// LinkProgramViaCode() compiles and links every stage on every launch, which for the
+// five-stage tessellation programs dominates startup; here a successful link is saved
+// (glGetProgramBinary) in a file named by a 64-bit hash of the stage sources and the
+// GL vendor, renderer and version strings, and later launches load it (glProgramBinary);
+// a missing, corrupt or rejected binary (eg, after a driver update) falls back to
+// compiling from source, which rewrites the file
+//
+// usage:
+//     program = LinkProgramViaCache(&vShaderCode, &pShaderCode);
+//     program = LinkProgramViaCache(&vShaderCode, &tcShaderCode, &teShaderCode, NULL, &pShaderCode);
+
+#ifndef PROGRAM_CACHE_HDR
+#define PROGRAM_CACHE_HDR
+
+#include <glad.h>
+
+extern const char *programCacheDir;
+    // directory of cached binaries, created as needed (default "ProgramCache"); NULL disables
+
+GLuint LinkProgramViaCache(const char **vCode, const char **pCode);
+GLuint LinkProgramViaCache(const char **vCode, const char **tcCode, const char **teCode,
+                           const char **gCode, const char **pCode);
+    // as LinkProgramViaCode(), stages may be NULL; compile errors are reported by it
+
+#endif
@@ -0,0 +1,46 @@
+// Redraw.cpp - draw a frame only when something has changed
+
+#include <stddef.h>
+#include <atomic>
+#include "Redraw.h"
+
+static std::atomic<bool> dirty(true), waiting(false);
+static bool continuous = false;
+static GLFWwindow *hooked = NULL;
+
+void Redraw() {
+    dirty = true;
+    // another thread may have changed the scene while the loop sleeps
+    if (waiting)
+        glfwPostEmptyEvent();
+}
+
+void RedrawContinuously(bool on) {
+    continuous = on;
+    dirty = true;
+}
+
+bool Continuous() {
+    return continuous;
+}
+
+static void Refresh(GLFWwindow *) {
+    // window uncovered or resized: contents may be lost
+    Redraw();
+}
+
+bool NextFrame(GLFWwindow *w) {
+    if (w != hooked) {
+        glfwSetWindowRefreshCallback(w, Refresh);
+        hooked = w;
+    }
+    glfwPollEvents();
+    if (!continuous) {
+        waiting = true;
+        while (!dirty && !glfwWindowShouldClose(w))
+            glfwWaitEvents();
+        waiting = false;
+    }
+    dirty = false;
+    return !glfwWindowShouldClose(w);
+}
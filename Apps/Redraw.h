@@ -0,0 +1,32 @@
+// Redraw.h - draw a frame only when something has changed
+//
+// a loop of Display(), glfwSwapBuffers(), glfwPollEvents() redraws the same image
+// every refresh while the camera, light and control points are still, keeping a
+// core busy; here input callbacks, Resize() and other changes of state call
+// Redraw(), and NextFrame() sleeps in glfwWaitEvents() until one does. Animated
+// apps call RedrawContinuously(true) for the polling loop; window exposure also
+// triggers a redraw
+//
+// usage:
+//     void MouseMove(GLFWwindow *w, double x, double y) {
+//         if (dragging) { camera.MouseDrag(x, y); Redraw(); }
+//     }
+//     while (NextFrame(w)) {
+//         Display();
+//         glfwSwapBuffers(w);
+//     }
+
+#ifndef REDRAW_HDR
+#define REDRAW_HDR
+
+#include <GLFW/glfw3.h>
+
+void Redraw();
+    // mark the scene dirty; may be called from any thread
+void RedrawContinuously(bool on);
+    // if on, draw every frame (for animation), else only when dirty
+bool Continuous();
+bool NextFrame(GLFWwindow *w);
+    // process events, waiting if nothing is dirty; false if the window should close
+
+#endif
@@ -0,0 +1,325 @@
+// SoftRaster.cpp - tiled, multi-threaded software rasterizer
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include "SoftRaster.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SOFT_RASTER_SSE
+#endif
+
+using std::vector;
+
+static const int vertexGrain = 1024, binGrain = 256;
+static const float guardBand = 1 << 20;    // pixels beyond the screen edges kept by clipping
+
+// frame buffer
+
+void SoftRaster::Resize(int w, int h) {
+    width = w > 0? w : 1;
+    height = h > 0? h : 1;
+    tilesX = (width+tileSize-1)/tileSize;
+    tilesY = (height+tileSize-1)/tileSize;
+    color.assign((size_t) width*height*4, 0);
+    depth.assign((size_t) width*height+4, 1.f);    // +4: a row's last 4-pixel load may run past it
+    bins.clear();
+}
+
+void SoftRaster::Clear(vec3 c) {
+    uint8_t rgba[4] = {0, 0, 0, 255};
+    for (int k = 0; k < 3; k++)
+        rgba[k] = (uint8_t) (255*(c[k] < 0? 0 : c[k] > 1? 1 : c[k])+.5f);
+    uint32_t pixel;
+    memcpy(&pixel, rgba, 4);
+    pool.Run(height, [&](int y) {
+        uint32_t *row = (uint32_t *) &color[(size_t) y*width*4];
+        std::fill(row, row+width, pixel);
+        std::fill(&depth[(size_t) y*width], &depth[(size_t) (y+1)*width], 1.f);
+    });
+}
+
+bool SoftRaster::WritePPM(const char *filename) const {
+    FILE *out = fopen(filename, "wb");
+    if (!out)
+        return false;
+    fprintf(out, "P6\n%d %d\n255\n", width, height);
+    vector<uint8_t> rgb((size_t) width*3);
+    for (int y = height-1; y >= 0; y--) {
+        const uint8_t *s = &color[(size_t) y*width*4];
+        for (int x = 0; x < width; x++)
+            memcpy(&rgb[3*x], s+4*x, 3);
+        fwrite(rgb.data(), 1, rgb.size(), out);
+    }
+    bool ok = !ferror(out);
+    fclose(out);
+    return ok;
+}
+
+// setup
+
+int SoftRaster::Clip(const Vertex *in, int n, Vertex *out, int nVaryings, const float plane[4]) {
+    int m = 0;
+    for (int i = 0; i < n; i++) {
+        const Vertex &a = in[i], &b = in[(i+1)%n];
+        float da = plane[0]*a.clip.x+plane[1]*a.clip.y+plane[2]*a.clip.z+plane[3]*a.clip.w;
+        float db = plane[0]*b.clip.x+plane[1]*b.clip.y+plane[2]*b.clip.z+plane[3]*b.clip.w;
+        if (da >= 0)
+            out[m++] = a;
+        if ((da >= 0) != (db >= 0)) {
+            float t = da/(da-db);
+            Vertex &c = out[m++];
+            c.clip = a.clip+t*(b.clip-a.clip);
+            for (int k = 0; k < nVaryings; k++)
+                c.varyings[k] = a.varyings[k]+t*(b.varyings[k]-a.varyings[k]);
+        }
+    }
+    return m;
+}
+
+void SoftRaster::Setup(const Vertex *v[3], int nVaryings, vector<Triangle> &triangles) {
+    // trivially reject if wholly outside one side of the view volume
+    for (int k = 0; k < 3; k++)
+        for (float s = -1; s <= 1; s += 2)
+            if (s*v[0]->clip[k] > v[0]->clip.w && s*v[1]->clip[k] > v[1]->clip.w && s*v[2]->clip[k] > v[2]->clip.w)
+                return;
+    // clip to the near plane (z >= -w), giving a polygon of up to 4 vertices
+    Vertex tri[3] = {*v[0], *v[1], *v[2]}, poly[8], guarded[8];
+    const float nearPlane[4] = {0, 0, 1, 1};
+    int n = Clip(tri, 3, poly, nVaryings, nearPlane);
+    // a vertex just past the near plane can project arbitrarily far off screen, overflowing
+    // the conversion to int below; clip (rarely needed) to a guard band around the screen,
+    // adding at most one vertex per side
+    float gx = 2*(guardBand+.5f*width)/width, gy = 2*(guardBand+.5f*height)/height;
+    bool outside = false;
+    for (int i = 0; i < n; i++)
+        outside = outside || fabsf(poly[i].clip.x) > gx*poly[i].clip.w || fabsf(poly[i].clip.y) > gy*poly[i].clip.w;
+    if (outside) {
+        const float sides[4][4] = {{-1, 0, 0, gx}, {1, 0, 0, gx}, {0, -1, 0, gy}, {0, 1, 0, gy}};
+        for (int s = 0; s < 4; s++) {
+            n = Clip(poly, n, guarded, nVaryings, sides[s]);
+            std::copy(guarded, guarded+n, poly);
+        }
+    }
+    // to window coordinates, pixel centers at half-integers, snapped to 1/256 pixel (as GL)
+    float x[8], y[8], z[8], w[8];
+    for (int i = 0; i < n; i++) {
+        const vec4 &c = poly[i].clip;
+        w[i] = 1/c.w;
+        x[i] = floorf(256*(c.x*w[i]+1)*.5f*width+.5f)/256;
+        y[i] = floorf(256*(c.y*w[i]+1)*.5f*height+.5f)/256;
+        z[i] = (c.z*w[i]+1)*.5f;
+    }
+    // fan into triangles
+    for (int i = 1; i+1 < n; i++) {
+        int ids[3] = {0, i, i+1};
+        double area = ((double) x[i]-x[0])*((double) y[i+1]-y[0])-((double) x[i+1]-x[0])*((double) y[i]-y[0]);
+        if (area == 0)
+            continue;
+        Triangle t;
+        float xmin = x[0], xmax = x[0], ymin = y[0], ymax = y[0];
+        for (int k = 0; k < 3; k++) {
+            int a = ids[k], j = ids[(k+1)%3], l = ids[(k+2)%3];
+            // edge opposite vertex k, scaled to 1 at vertex k, so it is barycentric coordinate k
+            double ex = -((double) y[l]-y[j])/area, ey = ((double) x[l]-x[j])/area;
+            t.e[k][0] = (float) ex;
+            t.e[k][1] = (float) ey;
+            t.e[k][2] = (float) (-ex*x[j]-ey*y[j]);
+            t.inclusive[k] = ex > 0 || (ex == 0 && ey > 0);
+            t.z[k] = z[a];
+            t.w[k] = w[a];
+            for (int m = 0; m < nVaryings; m++)
+                t.varyings[k][m] = poly[a].varyings[m]*w[a];
+            xmin = std::min(xmin, x[a]);
+            xmax = std::max(xmax, x[a]);
+            ymin = std::min(ymin, y[a]);
+            ymax = std::max(ymax, y[a]);
+        }
+        // pixels whose centers lie within the bounds, on screen
+        t.x0 = std::max(0, (int) ceilf(xmin-.5f));
+        t.y0 = std::max(0, (int) ceilf(ymin-.5f));
+        t.x1 = std::min(width-1, (int) floorf(xmax-.5f));
+        t.y1 = std::min(height-1, (int) floorf(ymax-.5f));
+        if (t.x0 <= t.x1 && t.y0 <= t.y1)
+            triangles.push_back(t);
+    }
+}
+
+void SoftRaster::Bin(const Triangle &t, int id, vector<vector<int>> &tileBins) {
+    for (int ty = t.y0/tileSize; ty <= t.y1/tileSize; ty++)
+        for (int tx = t.x0/tileSize; tx <= t.x1/tileSize; tx++) {
+            // skip a tile wholly outside an edge: test the tile corner furthest inside it
+            float x0 = (float) tx*tileSize+.5f, y0 = (float) ty*tileSize+.5f, x1 = x0+tileSize-1, y1 = y0+tileSize-1;
+            bool outside = false;
+            for (int k = 0; k < 3 && !outside; k++)
+                outside = t.e[k][0]*(t.e[k][0] > 0? x1 : x0)+t.e[k][1]*(t.e[k][1] > 0? y1 : y0)+t.e[k][2] < 0;
+            if (!outside)
+                tileBins[ty*tilesX+tx].push_back(id);
+        }
+}
+
+// rasterize
+
+void SoftRaster::Rasterize(int tile, int nVaryings, const PixelFunction &pixel) {
+    int tx0 = (tile%tilesX)*tileSize, ty0 = (tile/tilesX)*tileSize;
+    int tx1 = std::min(width, tx0+tileSize)-1, ty1 = std::min(height, ty0+tileSize)-1;
+    auto Shade = [&](const Triangle &t, int x, int y, const float l[3], float z) {
+        // perspective-correct varyings: interpolate v/w and 1/w linearly, then divide
+        float varyings[maxVaryings], w = 1/(l[0]*t.w[0]+l[1]*t.w[1]+l[2]*t.w[2]);
+        for (int k = 0; k < nVaryings; k++)
+            varyings[k] = w*(l[0]*t.varyings[0][k]+l[1]*t.varyings[1][k]+l[2]*t.varyings[2][k]);
+        vec3 c = pixel(varyings);
+        size_t i = (size_t) y*width+x;
+        uint8_t *p = &color[4*i];
+        for (int k = 0; k < 3; k++)
+            p[k] = (uint8_t) (255*(c[k] < 0? 0 : c[k] > 1? 1 : c[k])+.5f);
+        p[3] = 255;
+        depth[i] = z;
+    };
+    // triangles in submission order: binning jobs in order, then in order within each
+    for (size_t job = 0; job < bins.size(); job++)
+        for (int id : bins[job][tile]) {
+            const Triangle &t = setup[job][id];
+            int x0 = std::max(t.x0, tx0), y0 = std::max(t.y0, ty0);
+            int x1 = std::min(t.x1, tx1), y1 = std::min(t.y1, ty1);
+            if (x0 > x1 || y0 > y1)
+                continue;
+#ifdef SOFT_RASTER_SSE
+            // four pixels at a time, from a multiple of 4 (lanes left of x0 fail an edge)
+            x0 &= ~3;
+            __m128 lane = _mm_setr_ps(0, 1, 2, 3), zero = _mm_setzero_ps(), last = _mm_set1_ps((float) x1);
+            __m128 ex[3], step[3];
+            for (int k = 0; k < 3; k++) {
+                ex[k] = _mm_mul_ps(_mm_set1_ps(t.e[k][0]), lane);
+                step[k] = _mm_set1_ps(4*t.e[k][0]);
+            }
+            __m128 z0 = _mm_set1_ps(t.z[0]), z1 = _mm_set1_ps(t.z[1]-t.z[0]), z2 = _mm_set1_ps(t.z[2]-t.z[0]);
+            for (int y = y0; y <= y1; y++) {
+                __m128 e[3];
+                for (int k = 0; k < 3; k++)
+                    e[k] = _mm_add_ps(ex[k], _mm_set1_ps(t.e[k][0]*(x0+.5f)+t.e[k][1]*(y+.5f)+t.e[k][2]));
+                __m128 xs = _mm_add_ps(_mm_set1_ps((float) x0), lane);
+                for (int x = x0; x <= x1; x += 4) {
+                    __m128 in = _mm_cmple_ps(xs, last);
+                    for (int k = 0; k < 3; k++)
+                        in = _mm_and_ps(in, t.inclusive[k]? _mm_cmpge_ps(e[k], zero) : _mm_cmpgt_ps(e[k], zero));
+                    if (_mm_movemask_ps(in)) {
+                        __m128 z = _mm_add_ps(z0, _mm_add_ps(_mm_mul_ps(e[1], z1), _mm_mul_ps(e[2], z2)));
+                        in = _mm_and_ps(in, _mm_cmplt_ps(z, _mm_loadu_ps(&depth[(size_t) y*width+x])));
+                        if (int bits = _mm_movemask_ps(in)) {
+                            alignas(16) float l[3][4], zs[4];
+                            for (int k = 0; k < 3; k++)
+                                _mm_store_ps(l[k], e[k]);
+                            _mm_store_ps(zs, z);
+                            for (int i = 0; i < 4; i++)
+                                if (bits & (1 << i)) {
+                                    float li[3] = {l[0][i], l[1][i], l[2][i]};
+                                    Shade(t, x+i, y, li, zs[i]);
+                                }
+                        }
+                    }
+                    for (int k = 0; k < 3; k++)
+                        e[k] = _mm_add_ps(e[k], step[k]);
+                    xs = _mm_add_ps(xs, _mm_set1_ps(4));
+                }
+            }
+#else
+            for (int y = y0; y <= y1; y++)
+                for (int x = x0; x <= x1; x++) {
+                    float l[3];
+                    bool in = true;
+                    for (int k = 0; k < 3 && in; k++) {
+                        l[k] = t.e[k][0]*(x+.5f)+t.e[k][1]*(y+.5f)+t.e[k][2];
+                        in = t.inclusive[k]? l[k] >= 0 : l[k] > 0;
+                    }
+                    float z = t.z[0]+l[1]*(t.z[1]-t.z[0])+l[2]*(t.z[2]-t.z[0]);
+                    if (in && z < depth[(size_t) y*width+x])
+                        Shade(t, x, y, l, z);
+                }
+#endif
+        }
+}
+
+// draw
+
+void SoftRaster::Draw(int nVertices, const int *triangles, int nTriangles, int nVaryings,
+                      const VertexFunction &vertex, const PixelFunction &pixel) {
+    if (!width)
+        Resize(1, 1);
+    nVaryings = std::min(nVaryings, (int) maxVaryings);
+    // vertex stage
+    vertices.resize(nVertices);
+    pool.Run((nVertices+vertexGrain-1)/vertexGrain, [&](int job) {
+        for (int i = job*vertexGrain, end = std::min(nVertices, i+vertexGrain); i < end; i++)
+            vertices[i].clip = vertex(i, vertices[i].varyings);
+    });
+    // setup and binning, contiguous ranges of triangles per job so tiles keep their order
+    int nJobs = std::max(1, std::min(pool.NThreads(), nTriangles/binGrain));
+    int nTiles = tilesX*tilesY;
+    if ((int) bins.size() != nJobs) {
+        bins.assign(nJobs, vector<vector<int>>(nTiles));
+        setup.resize(nJobs);
+    }
+    pool.Run(nJobs, [&](int job) {
+        vector<Triangle> &s = setup[job];
+        vector<vector<int>> &b = bins[job];
+        s.clear();
+        for (vector<int> &tileBin : b)
+            tileBin.clear();
+        int begin = (int) ((long long) nTriangles*job/nJobs), end = (int) ((long long) nTriangles*(job+1)/nJobs);
+        for (int i = begin; i < end; i++) {
+            const int *ids = triangles+3*i;
+            const Vertex *v[3] = {&vertices[ids[0]], &vertices[ids[1]], &vertices[ids[2]]};
+            size_t first = s.size();
+            Setup(v, nVaryings, s);
+            for (size_t k = first; k < s.size(); k++)
+                Bin(s[k], (int) k, b);
+        }
+    });
+    // tiles
+    pool.Run(nTiles, [&](int tile) { Rasterize(tile, nVaryings, pixel); });
+}
+
+// apps' --soft option
+
+int RenderSoftFrames(const char *filename, int ac, char **av, const std::function<void(SoftRaster &)> &draw,
+                     vec3 background) {
+    int width = 1920, height = 1080, nFrames = 10, nThreads = 0;
+    bool stress = false;
+    for (int i = 1; i < ac; i++) {
+        if (!strcmp(av[i], "--size") && i+1 < ac)
+            sscanf(av[++i], "%dx%d", &width, &height);
+        else if (!strcmp(av[i], "--frames") && i+1 < ac)
+            nFrames = std::max(1, atoi(av[++i]));
+        else if (!strcmp(av[i], "--threads") && i+1 < ac)
+            nThreads = atoi(av[++i]);
+        else
+            stress = stress || !strcmp(av[i], "--stress");
+    }
+    if (stress) {
+        int nWrong = StressJobPool(nThreads);
+        printf("job pool stress: %i jobs not run exactly once\n", nWrong);
+        if (nWrong)
+            return 1;
+    }
+    SoftRaster raster(nThreads);
+    raster.Resize(width, height);
+    vector<float> ms;
+    for (int i = 0; i < nFrames; i++) {
+        auto start = std::chrono::steady_clock::now();
+        raster.Clear(background);
+        draw(raster);
+        ms.push_back(std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now()-start).count());
+    }
+    std::sort(ms.begin(), ms.end());
+    printf("%ix%i, %i threads: %.2f ms min, %.2f ms median\n", width, height, raster.NThreads(), ms[0], ms[ms.size()/2]);
+    if (!raster.WritePPM(filename)) {
+        printf("can't write %s\n", filename);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,92 @@
+// SoftRaster.h - tiled, multi-threaded software rasterizer, for rendering without a GL driver
+//
+// the apps' shaders are re-expressed as C++ functions: a vertex function returns the
+// clip-space position and writes the varyings (up to maxVaryings floats), and a pixel
+// function returns the color from the interpolated varyings; Draw() then
+//   - runs the vertex function over the vertices, in parallel
+//   - clips each triangle to the near plane (and, when needed, to a guard band around the
+//     screen), sets up its edge functions, and bins it into the 64x64 screen tiles its
+//     bounding box overlaps (one bin list per binning job, so no locks)
+//   - rasterizes the tiles on a JobPool, one tile per job, so a pixel is only ever touched
+//     by one thread; edge functions and the depth test are evaluated four pixels at a time
+//     with SSE, and varyings are interpolated perspective-correct (via 1/w) for the
+//     pixels that pass
+// rasterization follows GL: pixel centers at half-integers, a top-left style fill rule so
+// that shared edges are drawn once, depth in [0,1] tested GL_LESS, no face culling
+//
+// usage:
+//     SoftRaster raster;
+//     raster.Resize(1920, 1080);
+//     raster.Clear(vec3(.5f, .5f, .5f));
+//     raster.Draw(nVertices, triangles, nTriangles, nVaryings,
+//                 [&](int i, float *v) { ...write varyings...; return persp*modelview*vec4(points[i], 1); },
+//                 [&](const float *v) { return ...color...; });
+//     raster.WritePPM("face.ppm");
+//
+// the apps' --soft option is RenderSoftFrames(), with a draw function that calls Draw()
+
+#ifndef SOFT_RASTER_HDR
+#define SOFT_RASTER_HDR
+
+#include <stdint.h>
+#include <functional>
+#include <vector>
+#include "Parallel.h"
+#include "VecMat.h"
+
+class SoftRaster {
+public:
+    static const int maxVaryings = 8, tileSize = 64;
+    typedef std::function<vec4(int vertex, float *varyings)> VertexFunction;
+    typedef std::function<vec3(const float *varyings)> PixelFunction;
+    SoftRaster(int nThreads = 0) : pool(nThreads) { }
+        // nThreads as for JobPool (0: one per hardware thread)
+    int NThreads() const { return pool.NThreads(); }
+    void Resize(int width, int height);
+    int Width() const { return width; }
+    int Height() const { return height; }
+    void Clear(vec3 color);
+        // set every pixel to color, depth to 1
+    void Draw(int nVertices, const int *triangles, int nTriangles, int nVaryings,
+              const VertexFunction &vertex, const PixelFunction &pixel);
+        // rasterize nTriangles (3 vertex ids each); the functions are called from several
+        // threads at once, so must only read shared state
+    const uint8_t *Pixels() const { return color.data(); }
+        // RGBA, bottom row first (as from glReadPixels), Width()*4 bytes per row
+    bool WritePPM(const char *filename) const;
+        // binary PPM, top row first
+private:
+    struct Vertex {
+        vec4 clip;
+        float varyings[maxVaryings];
+    };
+    struct Triangle {
+        float e[3][3];                      // edge i: e[i][0]*x+e[i][1]*y+e[i][2], barycentric i inside
+        bool inclusive[3];                  // edge owns pixel centers exactly on it (fill rule)
+        float z[3], w[3];                   // window depth and 1/w at the vertices
+        float varyings[3][maxVaryings];     // pre-divided by w
+        int x0, y0, x1, y1;                 // pixel bounds, inclusive
+    };
+    JobPool pool;
+    int width = 0, height = 0, tilesX = 0, tilesY = 0;
+    std::vector<uint8_t> color;
+    std::vector<float> depth;
+    std::vector<Vertex> vertices;
+    std::vector<std::vector<Triangle>> setup;           // per binning job
+    std::vector<std::vector<std::vector<int>>> bins;    // per binning job, per tile: ids into setup
+    void Setup(const Vertex *v[3], int nVaryings, std::vector<Triangle> &triangles);
+    static int Clip(const Vertex *in, int n, Vertex *out, int nVaryings, const float plane[4]);
+        // part of polygon in (n vertices) where plane . clip >= 0, into out; return its count
+    void Bin(const Triangle &t, int id, std::vector<std::vector<int>> &tileBins);
+    void Rasterize(int tile, int nVaryings, const PixelFunction &pixel);
+};
+
+int RenderSoftFrames(const char *filename, int ac, char **av, const std::function<void(SoftRaster &)> &draw,
+                     vec3 background = vec3(.5f, .5f, .5f));
+    // parse --size WxH (default 1920x1080), --frames n (default 10), --threads n (default one
+    // per hardware thread) and --stress (first check the job pool with StressJobPool());
+    // clear and draw() --frames times, print the time per frame, write the last frame
+    // to filename; return a process exit code
+    // draw() is called after the raster is sized, so it may size the camera to it
+
+#endif
@@ -0,0 +1,143 @@
+// Tessellate.cpp - CPU tessellation of bicubic Bezier patches into indexed grids
+
+#include <math.h>
+#include "Tessellate.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define TESSELLATE_SSE
+#endif
+
+void PatchTessellator::SetResolution(int r) {
+    r = r < 1? 1 : r > maxRes? maxRes : r;
+    if (r == res)
+        return;
+    res = r;
+    // cubic Bernstein basis and derivatives, padded to a multiple of 4 for SIMD loads
+    int n = res+1, padded = (n+3) & ~3;
+    for (int k = 0; k < 4; k++) {
+        b[k].assign(padded, 0);
+        db[k].assign(padded, 0);
+    }
+    for (int i = 0; i < n; i++) {
+        float t = (float) i/res, u = 1-t;
+        b[0][i] = u*u*u;
+        b[1][i] = 3*t*u*u;
+        b[2][i] = 3*t*t*u;
+        b[3][i] = t*t*t;
+        db[0][i] = -3*u*u;
+        db[1][i] = 3*u*u-6*t*u;
+        db[2][i] = 6*t*u-3*t*t;
+        db[3][i] = 3*t*t;
+    }
+    // two triangles per grid quad
+    triangles.resize(6*res*res);
+    int *tri = triangles.data();
+    for (int i = 0; i < res; i++)
+        for (int j = 0; j < res; j++) {
+            int v00 = i*n+j, v01 = v00+1, v10 = v00+n, v11 = v10+1;
+            tri[0] = v00; tri[1] = v01; tri[2] = v11;
+            tri[3] = v00; tri[4] = v11; tri[5] = v10;
+            tri += 6;
+        }
+}
+
+void PatchTessellator::Tessellate(const vec3 ctrlPts[4][4], vec3 *points, vec3 *normals) const {
+    int n = res+1;
+    for (int i = 0; i < n; i++) {
+        // reduce patch to a cubic in s at t = i/res: row points and their t-derivatives
+        vec3 r[4], dr[4];
+        for (int j = 0; j < 4; j++) {
+            r[j] = b[0][i]*ctrlPts[0][j]+b[1][i]*ctrlPts[1][j]+b[2][i]*ctrlPts[2][j]+b[3][i]*ctrlPts[3][j];
+            dr[j] = db[0][i]*ctrlPts[0][j]+db[1][i]*ctrlPts[1][j]+db[2][i]*ctrlPts[2][j]+db[3][i]*ctrlPts[3][j];
+        }
+        vec3 *p = points+i*n, *nrm = normals+i*n;
+        int j = 0;
+#ifdef TESSELLATE_SSE
+        // four grid points along s per iteration
+        __m128 rx[4], ry[4], rz[4], dx[4], dy[4], dz[4];
+        for (int k = 0; k < 4; k++) {
+            rx[k] = _mm_set1_ps(r[k].x); ry[k] = _mm_set1_ps(r[k].y); rz[k] = _mm_set1_ps(r[k].z);
+            dx[k] = _mm_set1_ps(dr[k].x); dy[k] = _mm_set1_ps(dr[k].y); dz[k] = _mm_set1_ps(dr[k].z);
+        }
+        for (; j+4 <= n; j += 4) {
+            __m128 px = _mm_setzero_ps(), py = px, pz = px;     // point
+            __m128 sx = px, sy = px, sz = px;                   // d/ds
+            __m128 tx = px, ty = px, tz = px;                   // d/dt
+            for (int k = 0; k < 4; k++) {
+                __m128 bk = _mm_loadu_ps(&b[k][j]), dbk = _mm_loadu_ps(&db[k][j]);
+                px = _mm_add_ps(px, _mm_mul_ps(bk, rx[k]));
+                py = _mm_add_ps(py, _mm_mul_ps(bk, ry[k]));
+                pz = _mm_add_ps(pz, _mm_mul_ps(bk, rz[k]));
+                sx = _mm_add_ps(sx, _mm_mul_ps(dbk, rx[k]));
+                sy = _mm_add_ps(sy, _mm_mul_ps(dbk, ry[k]));
+                sz = _mm_add_ps(sz, _mm_mul_ps(dbk, rz[k]));
+                tx = _mm_add_ps(tx, _mm_mul_ps(bk, dx[k]));
+                ty = _mm_add_ps(ty, _mm_mul_ps(bk, dy[k]));
+                tz = _mm_add_ps(tz, _mm_mul_ps(bk, dz[k]));
+            }
+            // normal = ds x dt, normalized (zero where degenerate)
+            __m128 nx = _mm_sub_ps(_mm_mul_ps(sy, tz), _mm_mul_ps(sz, ty));
+            __m128 ny = _mm_sub_ps(_mm_mul_ps(sz, tx), _mm_mul_ps(sx, tz));
+            __m128 nz = _mm_sub_ps(_mm_mul_ps(sx, ty), _mm_mul_ps(sy, tx));
+            __m128 len2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, nx), _mm_mul_ps(ny, ny)), _mm_mul_ps(nz, nz));
+            __m128 scale = _mm_and_ps(_mm_cmpgt_ps(len2, _mm_setzero_ps()), _mm_div_ps(_mm_set1_ps(1), _mm_sqrt_ps(len2)));
+            nx = _mm_mul_ps(nx, scale);
+            ny = _mm_mul_ps(ny, scale);
+            nz = _mm_mul_ps(nz, scale);
+            float fp[3][4], fn[3][4];
+            _mm_storeu_ps(fp[0], px); _mm_storeu_ps(fp[1], py); _mm_storeu_ps(fp[2], pz);
+            _mm_storeu_ps(fn[0], nx); _mm_storeu_ps(fn[1], ny); _mm_storeu_ps(fn[2], nz);
+            for (int k = 0; k < 4; k++) {
+                p[j+k] = vec3(fp[0][k], fp[1][k], fp[2][k]);
+                nrm[j+k] = vec3(fn[0][k], fn[1][k], fn[2][k]);
+            }
+        }
+#endif
+        for (; j < n; j++) {
+            vec3 pt(0, 0, 0), ds(0, 0, 0), dt(0, 0, 0);
+            for (int k = 0; k < 4; k++) {
+                pt += b[k][j]*r[k];
+                ds += db[k][j]*r[k];
+                dt += b[k][j]*dr[k];
+            }
+            p[j] = pt;
+            nrm[j] = normalize(cross(ds, dt));
+        }
+    }
+}
+
+// screen-space adaptive levels
+
+static vec2 ScreenPoint(const vec3 &p, const mat4 &fullview, int width, int height) {
+    // pixel offset from screen center; points behind the eye project far away (maximum level)
+    vec4 c = fullview*vec4(p, 1);
+    float w = c.w > .001f? c.w : .001f;
+    return vec2(.5f*width*c.x/w, .5f*height*c.y/w);
+}
+
+static float Distance(const vec2 &a, const vec2 &b) {
+    float dx = a.x-b.x, dy = a.y-b.y;
+    return sqrtf(dx*dx+dy*dy);
+}
+
+float EdgeLevel(const vec3 &p0, const vec3 &p1, const vec3 &p2, const vec3 &p3,
+                const mat4 &fullview, int width, int height, float pixelsPerSegment) {
+    vec2 a = ScreenPoint(p0, fullview, width, height), b = ScreenPoint(p1, fullview, width, height);
+    vec2 c = ScreenPoint(p2, fullview, width, height), d = ScreenPoint(p3, fullview, width, height);
+    // (ab+cd)+bc: the same sum whichever end the edge is traversed from
+    float len = (Distance(a, b)+Distance(c, d))+Distance(b, c);
+    float level = ceilf(len/pixelsPerSegment);
+    return level < 1? 1 : level > maxTessLevel? maxTessLevel : level;
+}
+
+void PatchLevels(const vec3 ctrlPts[4][4], const mat4 &fullview, int width, int height,
+                 float pixelsPerSegment, float outer[4], float inner[2]) {
+    const vec3 (*c)[4] = ctrlPts;
+    outer[0] = EdgeLevel(c[0][0], c[1][0], c[2][0], c[3][0], fullview, width, height, pixelsPerSegment);
+    outer[1] = EdgeLevel(c[0][0], c[0][1], c[0][2], c[0][3], fullview, width, height, pixelsPerSegment);
+    outer[2] = EdgeLevel(c[0][3], c[1][3], c[2][3], c[3][3], fullview, width, height, pixelsPerSegment);
+    outer[3] = EdgeLevel(c[3][0], c[3][1], c[3][2], c[3][3], fullview, width, height, pixelsPerSegment);
+    inner[0] = outer[1] > outer[3]? outer[1] : outer[3];
+    inner[1] = outer[0] > outer[2]? outer[0] : outer[2];
+}
@@ -0,0 +1,61 @@
+// Tessellate.h - CPU tessellation of bicubic Bezier patches into indexed grids
+//
+// evaluating each vertex with BezierPoint() calls (pow() per term, and each shared
+// vertex once per adjacent quad) is slow; here Bernstein basis values and derivatives
+// are tabulated once per resolution, each patch row is reduced to four curve points
+// (plus their t-derivatives), and points and normals along the row are evaluated four
+// grid points at a time with SSE; every vertex is computed once and the quads share it
+// through the index list, which depends only on the resolution
+//
+// also serves as the fallback where tessellation shaders (GL 4.0) are unavailable
+//
+// usage:
+//     PatchTessellator tess;
+//     tess.SetResolution(res);                        // (res+1)^2 vertices, 2*res*res triangles
+//     tess.Tessellate(ctrlPts, points, normals);      // per patch, whenever ctrlPts change
+//     indices.Allocate(tess.Triangles().data(), tess.Triangles().size(), tess.NVertices());
+//
+// PatchLevels() picks tessellation levels from the projected size of a patch, as the
+// tessellation control shader in 19-Stub-Tess.cpp does on the GPU
+
+#ifndef TESSELLATE_HDR
+#define TESSELLATE_HDR
+
+#include <vector>
+#include "VecMat.h"
+
+class PatchTessellator {
+public:
+    static const int maxRes = 512;
+    void SetResolution(int res);
+        // res quads along each side of a patch, 1 to maxRes
+    int Resolution() const { return res; }
+    int NVertices() const { return (res+1)*(res+1); }
+    const std::vector<int> &Triangles() const { return triangles; }
+        // 3 vertex ids per triangle, for one patch (offset ids by patch*NVertices() for more)
+    void Tessellate(const vec3 ctrlPts[4][4], vec3 *points, vec3 *normals) const;
+        // write NVertices() points and unit normals; vertex (s, t) = (j/res, i/res) is at i*(res+1)+j
+        // ctrlPts indexed [t][s], as in the tessellation evaluation shaders; normal is ds x dt
+        // const, so several threads may tessellate different patches at once
+private:
+    int res = 0;
+    std::vector<float> b[4], db[4];         // Bernstein basis and derivative at k/res, k = 0..res (+ SIMD padding)
+    std::vector<int> triangles;
+};
+
+// screen-space adaptive levels
+
+const float maxTessLevel = 64;              // GL_MAX_TESS_GEN_LEVEL is at least 64
+
+float EdgeLevel(const vec3 &p0, const vec3 &p1, const vec3 &p2, const vec3 &p3,
+                const mat4 &fullview, int width, int height, float pixelsPerSegment);
+    // segments for a patch edge: projected length (pixels) of its control polygon / pixelsPerSegment,
+    // rounded up and clamped to [1, maxTessLevel]; depends only on the edge's own control points
+    // and is symmetric in their order, so patches sharing the edge agree and leave no crack
+
+void PatchLevels(const vec3 ctrlPts[4][4], const mat4 &fullview, int width, int height,
+                 float pixelsPerSegment, float outer[4], float inner[2]);
+    // gl_TessLevelOuter/Inner for a quad patch: outer edges s = 0, t = 0, s = 1, t = 1;
+    // inner levels along s and t are the larger of the two opposite outer levels
+
+#endif
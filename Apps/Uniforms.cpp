@@ -0,0 +1,212 @@
+// Uniforms.cpp - per-program cache of uniform and attribute locations
+
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include "Uniforms.h"
+
+// tables
+
+struct Slot {
+    std::string name;
+    unsigned    hash;
+    GLint       location;
+    const char *key;        // last name pointer that matched, for the fast path (contents re-checked)
+};
+
+struct ProgramLocations {
+    bool cached = false;
+    std::vector<Slot> uniforms, attributes;
+    std::vector<std::string> missing;       // names already reported as not found
+};
+
+static std::vector<ProgramLocations> programs;      // indexed by program id
+
+static unsigned Hash(const char *s, size_t len) {
+    // FNV-1a
+    unsigned h = 2166136261u;
+    for (size_t i = 0; i < len; i++)
+        h = (h^(unsigned char) s[i])*16777619u;
+    return h;
+}
+
+static void AddSlot(std::vector<Slot> &slots, const char *name, GLint location, bool plain = true) {
+    size_t len = strlen(name);
+    // array uniforms report as "name[0]"; store plain name (and, for uniforms, each element)
+    if (plain && len > 3 && !strcmp(name+len-3, "[0]"))
+        len -= 3;
+    Slot s;
+    s.name.assign(name, len);
+    s.hash = Hash(name, len);
+    s.location = location;
+    s.key = NULL;
+    slots.push_back(s);
+}
+
+void CacheLocations(GLuint program) {
+    if (!program)
+        return;
+    if (program >= programs.size())
+        programs.resize(program+1);
+    ProgramLocations &p = programs[program];
+    p.uniforms.clear();
+    p.attributes.clear();
+    p.missing.clear();
+    GLint nUniforms = 0, nAttributes = 0, maxLen = 0, maxAttribLen = 0;
+    glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &nUniforms);
+    glGetProgramiv(program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLen);
+    glGetProgramiv(program, GL_ACTIVE_ATTRIBUTES, &nAttributes);
+    glGetProgramiv(program, GL_ACTIVE_ATTRIBUTE_MAX_LENGTH, &maxAttribLen);
+    std::vector<char> name((maxLen > maxAttribLen? maxLen : maxAttribLen)+1);
+    for (GLint i = 0; i < nUniforms; i++) {
+        GLint size;
+        GLenum type;
+        glGetActiveUniform(program, i, (GLsizei) name.size(), NULL, &size, &type, name.data());
+        GLint location = glGetUniformLocation(program, name.data());
+        if (location < 0)               // skip block members and gl_ built-ins
+            continue;
+        AddSlot(p.uniforms, name.data(), location);
+        // elements of an array, as "name[k]"
+        size_t len = strlen(name.data());
+        if (len > 3 && !strcmp(name.data()+len-3, "[0]")) {
+            std::string base(name.data(), len-3);
+            AddSlot(p.uniforms, name.data(), location, false);
+            for (GLint k = 1; k < size; k++) {
+                std::string element = base+"["+std::to_string(k)+"]";
+                GLint elementLocation = glGetUniformLocation(program, element.c_str());
+                if (elementLocation >= 0)
+                    AddSlot(p.uniforms, element.c_str(), elementLocation);
+            }
+        }
+    }
+    for (GLint i = 0; i < nAttributes; i++) {
+        GLint size;
+        GLenum type;
+        glGetActiveAttrib(program, i, (GLsizei) name.size(), NULL, &size, &type, name.data());
+        GLint location = glGetAttribLocation(program, name.data());
+        if (location >= 0)
+            AddSlot(p.attributes, name.data(), location);
+    }
+    p.cached = true;
+}
+
+void ForgetLocations(GLuint program) {
+    if (program < programs.size())
+        programs[program] = ProgramLocations();
+}
+
+static GLint Find(std::vector<Slot> &slots, const char *name) {
+    // a pointer match is confirmed by content: a buffer reused for another name
+    // (eg, sprintf'd "mirror[%i]") falls through to the hashed compare
+    for (size_t i = 0; i < slots.size(); i++)
+        if (slots[i].key == name && !strcmp(slots[i].name.c_str(), name))
+            return slots[i].location;
+    size_t len = strlen(name);
+    unsigned h = Hash(name, len);
+    for (size_t i = 0; i < slots.size(); i++) {
+        Slot &s = slots[i];
+        if (s.hash == h && s.name.size() == len && !memcmp(s.name.data(), name, len)) {
+            // the pointer now keys this slot only
+            for (Slot &o : slots)
+                if (o.key == name)
+                    o.key = NULL;
+            s.key = name;
+            return s.location;
+        }
+    }
+    return -1;
+}
+
+static ProgramLocations *Locations(GLuint program) {
+    if (!program)
+        return NULL;
+    if (program >= programs.size() || !programs[program].cached)
+        CacheLocations(program);
+    return &programs[program];
+}
+
+static void ReportMissing(ProgramLocations *p, const char *kind, const char *name) {
+    // as GLXtras' SetUniform, but once per name, as lookups repeat every frame
+    std::string key = std::string(kind)+" "+name;
+    for (const std::string &m : p->missing)
+        if (m == key)
+            return;
+    p->missing.push_back(key);
+    printf("can't find %s\n", key.c_str());
+}
+
+GLint UniformLocation(GLuint program, const char *name) {
+    ProgramLocations *p = Locations(program);
+    GLint id = p? Find(p->uniforms, name) : -1;
+    if (id < 0 && p)
+        ReportMissing(p, "uniform", name);
+    return id;
+}
+
+GLint AttributeLocation(GLuint program, const char *name) {
+    ProgramLocations *p = Locations(program);
+    GLint id = p? Find(p->attributes, name) : -1;
+    if (id < 0 && p)
+        ReportMissing(p, "attribute", name);
+    return id;
+}
+
+// uniform setters
+
+bool SetUniform(GLint id, int i) {
+    if (id >= 0)
+        glUniform1i(id, i);
+    return id >= 0;
+}
+
+bool SetUniform(GLint id, float f) {
+    if (id >= 0)
+        glUniform1f(id, f);
+    return id >= 0;
+}
+
+bool SetUniform(GLint id, vec2 v) {
+    if (id >= 0)
+        glUniform2f(id, v.x, v.y);
+    return id >= 0;
+}
+
+bool SetUniform(GLint id, vec3 v) {
+    if (id >= 0)
+        glUniform3f(id, v.x, v.y, v.z);
+    return id >= 0;
+}
+
+bool SetUniform(GLint id, vec4 v) {
+    if (id >= 0)
+        glUniform4f(id, v.x, v.y, v.z, v.w);
+    return id >= 0;
+}
+
+bool SetUniform(GLint id, mat4 m) {
+    // mat4 is row-major, hence transpose
+    if (id >= 0)
+        glUniformMatrix4fv(id, 1, GL_TRUE, (float *) &m[0][0]);
+    return id >= 0;
+}
+
+bool SetUniform3v(GLint id, int count, const float *v) {
+    if (id >= 0)
+        glUniform3fv(id, count, v);
+    return id >= 0;
+}
+
+bool SetUniformMat4v(GLint id, int count, const mat4 *m) {
+    if (id >= 0)
+        glUniformMatrix4fv(id, count, GL_TRUE, (float *) m);
+    return id >= 0;
+}
+
+bool VertexAttribPointer(GLint id, GLint ncomponents, GLsizei stride, const void *offset) {
+    if (id < 0)
+        return false;
+    glEnableVertexAttribArray(id);
+    glVertexAttribPointer(id, ncomponents, GL_FLOAT, GL_FALSE, stride, offset);
+    return true;
+}
@@ -0,0 +1,50 @@
+// Uniforms.h - per-program cache of uniform and attribute locations
+//
+// GLXtras' SetUniform(program, "name", ...) and VertexAttribPointer(program, "name", ...)
+// ask the driver to resolve the name on every call; here each program's active
+// uniforms and attributes are resolved once, after link, into a small table.
+// Lookups try the slot last found by the caller's name pointer first (string literals
+// are interned), confirming its name, then fall back to a hashed name compare, so no
+// GL call is made per frame.
+//
+// usage:
+//     program = LinkProgramViaCode(...);
+//     CacheLocations(program);
+//     SetUniform(UniformLocation(program, "modelview"), camera.modelview);
+//     VertexAttribPointer(AttributeLocation(program, "point"), 3, 0, (void *) 0);
+
+#ifndef UNIFORMS_HDR
+#define UNIFORMS_HDR
+
+#include <glad.h>
+#include "VecMat.h"
+
+void CacheLocations(GLuint program);
+    // resolve all active uniforms and attributes of a linked program
+    // (called lazily by the lookups below if not called explicitly)
+
+void ForgetLocations(GLuint program);
+    // discard the table, eg after glDeleteProgram or relinking
+
+GLint UniformLocation(GLuint program, const char *name);
+GLint AttributeLocation(GLuint program, const char *name);
+    // return cached location, or -1 if name is not active in program (reported once per name)
+    // array uniforms may be named with or without the "[0]" suffix, and their
+    // elements as "name[k]"
+
+// set uniform of the current program via cached location; return false if location < 0
+
+bool SetUniform(GLint id, int i);
+bool SetUniform(GLint id, float f);
+bool SetUniform(GLint id, vec2 v);
+bool SetUniform(GLint id, vec3 v);
+bool SetUniform(GLint id, vec4 v);
+bool SetUniform(GLint id, mat4 m);
+bool SetUniform3v(GLint id, int count, const float *v);
+bool SetUniformMat4v(GLint id, int count, const mat4 *m);
+    // count array elements in one call
+
+bool VertexAttribPointer(GLint id, GLint ncomponents, GLsizei stride, const void *offset);
+    // enable attribute at cached location and set its float feed from the bound buffer
+
+#endif
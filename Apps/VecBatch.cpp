@@ -0,0 +1,389 @@
+// VecBatch.cpp - SIMD matrix-vector kernels and batch transforms for the VecMat types
+
+#include <math.h>
+#include <stdio.h>
+#include <vector>
+#include "Benchmark.h"
+#include "VecBatch.h"
+
+#if defined(__AVX2__) && (defined(__FMA__) || defined(_MSC_VER))
+#include <immintrin.h>
+#define VEC_BATCH_AVX2
+#define VEC_BATCH_SSE
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define VEC_BATCH_SSE
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define VEC_BATCH_NEON
+#endif
+
+using std::vector;
+
+static_assert(sizeof(vec3) == 12 && sizeof(vec4) == 16 && sizeof(mat4) == 64, "VecMat layout");
+
+const char *VecBatchSimd() {
+#if defined(VEC_BATCH_AVX2)
+    return "avx2";
+#elif defined(VEC_BATCH_SSE)
+    return "sse2";
+#elif defined(VEC_BATCH_NEON)
+    return "neon";
+#else
+    return "none";
+#endif
+}
+
+// lanes: the widest float vector available, one value per lane in SoA kernels
+
+#if defined(VEC_BATCH_AVX2)
+typedef __m256 Lanes;
+static const int nLanes = 8;
+static inline Lanes Set(float f) { return _mm256_set1_ps(f); }
+static inline Lanes Load(const float *p) { return _mm256_loadu_ps(p); }
+static inline void Store(float *p, Lanes a) { _mm256_storeu_ps(p, a); }
+static inline Lanes Sub(Lanes a, Lanes b) { return _mm256_sub_ps(a, b); }
+static inline Lanes Mul(Lanes a, Lanes b) { return _mm256_mul_ps(a, b); }
+static inline Lanes MulAdd(Lanes a, Lanes b, Lanes c) { return _mm256_fmadd_ps(a, b, c); }
+static inline Lanes InvLength(Lanes len2) {
+    // 1/sqrt(len2), or 1 where len2 is 0
+    Lanes one = _mm256_set1_ps(1);
+    return _mm256_blendv_ps(one, _mm256_div_ps(one, _mm256_sqrt_ps(len2)), _mm256_cmp_ps(len2, _mm256_setzero_ps(), _CMP_GT_OQ));
+}
+#elif defined(VEC_BATCH_SSE)
+typedef __m128 Lanes;
+static const int nLanes = 4;
+static inline Lanes Set(float f) { return _mm_set1_ps(f); }
+static inline Lanes Load(const float *p) { return _mm_loadu_ps(p); }
+static inline void Store(float *p, Lanes a) { _mm_storeu_ps(p, a); }
+static inline Lanes Sub(Lanes a, Lanes b) { return _mm_sub_ps(a, b); }
+static inline Lanes Mul(Lanes a, Lanes b) { return _mm_mul_ps(a, b); }
+static inline Lanes MulAdd(Lanes a, Lanes b, Lanes c) { return _mm_add_ps(_mm_mul_ps(a, b), c); }
+static inline Lanes InvLength(Lanes len2) {
+    Lanes one = _mm_set1_ps(1), nonzero = _mm_cmpgt_ps(len2, _mm_setzero_ps());
+    return _mm_or_ps(_mm_and_ps(nonzero, _mm_div_ps(one, _mm_sqrt_ps(len2))), _mm_andnot_ps(nonzero, one));
+}
+#elif defined(VEC_BATCH_NEON)
+typedef float32x4_t Lanes;
+static const int nLanes = 4;
+static inline Lanes Set(float f) { return vdupq_n_f32(f); }
+static inline Lanes Load(const float *p) { return vld1q_f32(p); }
+static inline void Store(float *p, Lanes a) { vst1q_f32(p, a); }
+static inline Lanes Sub(Lanes a, Lanes b) { return vsubq_f32(a, b); }
+static inline Lanes Mul(Lanes a, Lanes b) { return vmulq_f32(a, b); }
+static inline Lanes MulAdd(Lanes a, Lanes b, Lanes c) { return vfmaq_f32(c, a, b); }
+static inline Lanes InvLength(Lanes len2) {
+    Lanes one = vdupq_n_f32(1);
+    return vbslq_f32(vcgtq_f32(len2, vdupq_n_f32(0)), vdivq_f32(one, vsqrtq_f32(len2)), one);
+}
+#else
+typedef float Lanes;
+static const int nLanes = 1;
+static inline Lanes Set(float f) { return f; }
+static inline Lanes Load(const float *p) { return *p; }
+static inline void Store(float *p, Lanes a) { *p = a; }
+static inline Lanes Sub(Lanes a, Lanes b) { return a-b; }
+static inline Lanes Mul(Lanes a, Lanes b) { return a*b; }
+static inline Lanes MulAdd(Lanes a, Lanes b, Lanes c) { return a*b+c; }
+static inline Lanes InvLength(Lanes len2) { return len2 > 0? 1/sqrtf(len2) : 1; }
+#endif
+
+// nLanes vec3s to and from x, y and z lanes
+
+#if defined(VEC_BATCH_SSE)
+static inline void Load3x4(const vec3 *v, __m128 &x, __m128 &y, __m128 &z) {
+    // a = x0 y0 z0 x1, b = y1 z1 x2 y2, c = z2 x3 y3 z3
+    const float *f = &v->x;
+    __m128 a = _mm_loadu_ps(f), b = _mm_loadu_ps(f+4), c = _mm_loadu_ps(f+8);
+    x = _mm_shuffle_ps(a, _mm_shuffle_ps(b, c, _MM_SHUFFLE(0, 1, 0, 2)), _MM_SHUFFLE(2, 0, 3, 0));
+    y = _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(0, 0, 0, 1)), _mm_shuffle_ps(b, c, _MM_SHUFFLE(0, 2, 0, 3)), _MM_SHUFFLE(2, 0, 2, 0));
+    z = _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(0, 1, 0, 2)), _mm_shuffle_ps(c, c, _MM_SHUFFLE(0, 3, 0, 0)), _MM_SHUFFLE(2, 0, 2, 0));
+}
+static inline void Store3x4(vec3 *v, __m128 x, __m128 y, __m128 z) {
+    float *f = &v->x;
+    _mm_storeu_ps(f, _mm_shuffle_ps(_mm_shuffle_ps(x, y, 0), _mm_shuffle_ps(z, x, _MM_SHUFFLE(1, 1, 0, 0)), _MM_SHUFFLE(2, 0, 2, 0)));
+    _mm_storeu_ps(f+4, _mm_shuffle_ps(_mm_shuffle_ps(y, z, _MM_SHUFFLE(1, 1, 1, 1)), _mm_shuffle_ps(x, y, _MM_SHUFFLE(2, 2, 2, 2)), _MM_SHUFFLE(2, 0, 2, 0)));
+    _mm_storeu_ps(f+8, _mm_shuffle_ps(_mm_shuffle_ps(z, x, _MM_SHUFFLE(3, 3, 2, 2)), _mm_shuffle_ps(y, z, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(2, 0, 2, 0)));
+}
+#endif
+
+static inline void Load3(const vec3 *v, Lanes &x, Lanes &y, Lanes &z) {
+#if defined(VEC_BATCH_AVX2)
+    __m128 x0, y0, z0, x1, y1, z1;
+    Load3x4(v, x0, y0, z0);
+    Load3x4(v+4, x1, y1, z1);
+    x = _mm256_insertf128_ps(_mm256_castps128_ps256(x0), x1, 1);
+    y = _mm256_insertf128_ps(_mm256_castps128_ps256(y0), y1, 1);
+    z = _mm256_insertf128_ps(_mm256_castps128_ps256(z0), z1, 1);
+#elif defined(VEC_BATCH_SSE)
+    Load3x4(v, x, y, z);
+#elif defined(VEC_BATCH_NEON)
+    float32x4x3_t t = vld3q_f32(&v->x);
+    x = t.val[0];
+    y = t.val[1];
+    z = t.val[2];
+#else
+    x = v->x;
+    y = v->y;
+    z = v->z;
+#endif
+}
+
+static inline void Store3(vec3 *v, Lanes x, Lanes y, Lanes z) {
+#if defined(VEC_BATCH_AVX2)
+    Store3x4(v, _mm256_castps256_ps128(x), _mm256_castps256_ps128(y), _mm256_castps256_ps128(z));
+    Store3x4(v+4, _mm256_extractf128_ps(x, 1), _mm256_extractf128_ps(y, 1), _mm256_extractf128_ps(z, 1));
+#elif defined(VEC_BATCH_SSE)
+    Store3x4(v, x, y, z);
+#elif defined(VEC_BATCH_NEON)
+    float32x4x3_t t = {{x, y, z}};
+    vst3q_f32(&v->x, t);
+#else
+    *v = vec3(x, y, z);
+#endif
+}
+
+// matrix product
+
+mat4 Multiply(const mat4 &a, const mat4 &b) {
+#if defined(VEC_BATCH_SSE) || defined(VEC_BATCH_NEON)
+    // row i of a*b is the sum of b's rows weighted by row i of a
+    mat4 r;
+#if defined(VEC_BATCH_SSE)
+    __m128 b0 = _mm_loadu_ps(&b.row[0].x), b1 = _mm_loadu_ps(&b.row[1].x);
+    __m128 b2 = _mm_loadu_ps(&b.row[2].x), b3 = _mm_loadu_ps(&b.row[3].x);
+    for (int i = 0; i < 4; i++) {
+        const vec4 &ai = a.row[i];
+        __m128 s = _mm_add_ps(_mm_mul_ps(b0, _mm_set1_ps(ai.x)), _mm_mul_ps(b1, _mm_set1_ps(ai.y)));
+        s = _mm_add_ps(s, _mm_add_ps(_mm_mul_ps(b2, _mm_set1_ps(ai.z)), _mm_mul_ps(b3, _mm_set1_ps(ai.w))));
+        _mm_storeu_ps(&r.row[i].x, s);
+    }
+#else
+    float32x4_t b0 = vld1q_f32(&b.row[0].x), b1 = vld1q_f32(&b.row[1].x);
+    float32x4_t b2 = vld1q_f32(&b.row[2].x), b3 = vld1q_f32(&b.row[3].x);
+    for (int i = 0; i < 4; i++) {
+        const vec4 &ai = a.row[i];
+        vst1q_f32(&r.row[i].x, vfmaq_n_f32(vfmaq_n_f32(vfmaq_n_f32(vmulq_n_f32(b0, ai.x), b1, ai.y), b2, ai.z), b3, ai.w));
+    }
+#endif
+    return r;
+#else
+    return a*b;
+#endif
+}
+
+// arrays of points and vectors (AoS): one value per 4-wide op, matrix columns weighted by component
+
+#if defined(VEC_BATCH_SSE)
+typedef __m128 Lanes4;
+static inline void Store4(float *p, Lanes4 a) { _mm_storeu_ps(p, a); }
+static inline Lanes4 Zero4() { return _mm_setzero_ps(); }
+static inline void Columns(const mat4 &m, Lanes4 c[4]) {
+    c[0] = _mm_loadu_ps(&m.row[0].x);
+    c[1] = _mm_loadu_ps(&m.row[1].x);
+    c[2] = _mm_loadu_ps(&m.row[2].x);
+    c[3] = _mm_loadu_ps(&m.row[3].x);
+    _MM_TRANSPOSE4_PS(c[0], c[1], c[2], c[3]);
+}
+static inline Lanes4 Apply(const Lanes4 c[4], const vec3 &p, Lanes4 w) {
+    // c[0]*p.x+c[1]*p.y+c[2]*p.z+w
+    return _mm_add_ps(_mm_add_ps(_mm_mul_ps(c[0], _mm_set1_ps(p.x)), _mm_mul_ps(c[1], _mm_set1_ps(p.y))),
+                      _mm_add_ps(_mm_mul_ps(c[2], _mm_set1_ps(p.z)), w));
+}
+#define VEC_BATCH_AOS
+#elif defined(VEC_BATCH_NEON)
+typedef float32x4_t Lanes4;
+static inline void Store4(float *p, Lanes4 a) { vst1q_f32(p, a); }
+static inline Lanes4 Zero4() { return vdupq_n_f32(0); }
+static inline void Columns(const mat4 &m, Lanes4 c[4]) {
+    float32x4x4_t t = vld4q_f32(&m.row[0].x);
+    for (int k = 0; k < 4; k++)
+        c[k] = t.val[k];
+}
+static inline Lanes4 Apply(const Lanes4 c[4], const vec3 &p, Lanes4 w) {
+    return vfmaq_n_f32(vfmaq_n_f32(vfmaq_n_f32(w, c[0], p.x), c[1], p.y), c[2], p.z);
+}
+#define VEC_BATCH_AOS
+#endif
+
+void TransformPoints(const mat4 &m, const vec3 *points, vec4 *out, int n) {
+#ifdef VEC_BATCH_AOS
+    Lanes4 c[4];
+    Columns(m, c);
+    for (int i = 0; i < n; i++)
+        Store4(&out[i].x, Apply(c, points[i], c[3]));
+#else
+    mat4 mc = m;                                // not reloaded after each store
+    for (int i = 0; i < n; i++)
+        out[i] = mc*vec4(points[i].x, points[i].y, points[i].z, 1);
+#endif
+}
+
+void TransformPoints(const mat4 &m, const vec3 *points, vec3 *out, int n) {
+    int i = 0;
+#ifdef VEC_BATCH_AOS
+    // each 4-float store spills into the next value, which is written after it
+    Lanes4 c[4];
+    Columns(m, c);
+    for (; i < n-1; i++)
+        Store4(&out[i].x, Apply(c, points[i], c[3]));
+#endif
+    for (; i < n; i++) {
+        vec4 q = m*vec4(points[i].x, points[i].y, points[i].z, 1);
+        out[i] = vec3(q.x, q.y, q.z);
+    }
+}
+
+void TransformVectors(const mat4 &m, const vec3 *vectors, vec3 *out, int n) {
+    int i = 0;
+#ifdef VEC_BATCH_AOS
+    Lanes4 c[4];
+    Columns(m, c);
+    c[3] = Zero4();                             // w = 0: no translation
+    for (; i < n-1; i++)
+        Store4(&out[i].x, Apply(c, vectors[i], c[3]));
+#endif
+    for (; i < n; i++) {
+        vec4 q = m*vec4(vectors[i].x, vectors[i].y, vectors[i].z, 0);
+        out[i] = vec3(q.x, q.y, q.z);
+    }
+}
+
+// SoA and lane-parallel kernels
+
+void TransformPoints(const mat4 &m, const float *x, const float *y, const float *z,
+                     float *ox, float *oy, float *oz, float *ow, int n) {
+    int i = 0;
+    Lanes c[4][4];
+    for (int r = 0; r < 4; r++)
+        for (int k = 0; k < 4; k++)
+            c[r][k] = Set(m.row[r][k]);
+    auto Row = [&c](int r, Lanes px, Lanes py, Lanes pz) {
+        return MulAdd(c[r][0], px, MulAdd(c[r][1], py, MulAdd(c[r][2], pz, c[r][3])));
+    };
+    for (; i+nLanes <= n; i += nLanes) {
+        Lanes px = Load(x+i), py = Load(y+i), pz = Load(z+i);
+        Store(ox+i, Row(0, px, py, pz));
+        Store(oy+i, Row(1, px, py, pz));
+        Store(oz+i, Row(2, px, py, pz));
+        if (ow)
+            Store(ow+i, Row(3, px, py, pz));
+    }
+    for (; i < n; i++) {
+        // the remainder, fewer than nLanes
+        float px = x[i], py = y[i], pz = z[i];
+        const vec4 *r = m.row;
+        ox[i] = r[0].x*px+r[0].y*py+r[0].z*pz+r[0].w;
+        oy[i] = r[1].x*px+r[1].y*py+r[1].z*pz+r[1].w;
+        oz[i] = r[2].x*px+r[2].y*py+r[2].z*pz+r[2].w;
+        if (ow)
+            ow[i] = r[3].x*px+r[3].y*py+r[3].z*pz+r[3].w;
+    }
+}
+
+void Cross(const vec3 *a, const vec3 *b, vec3 *out, int n) {
+    int i = 0;
+    for (; i+nLanes <= n; i += nLanes) {
+        Lanes ax, ay, az, bx, by, bz;
+        Load3(a+i, ax, ay, az);
+        Load3(b+i, bx, by, bz);
+        Store3(out+i, Sub(Mul(ay, bz), Mul(az, by)), Sub(Mul(az, bx), Mul(ax, bz)), Sub(Mul(ax, by), Mul(ay, bx)));
+    }
+    for (; i < n; i++)
+        out[i] = cross(a[i], b[i]);
+}
+
+void Normalize(vec3 *v, int n) {
+    int i = 0;
+    for (; i+nLanes <= n; i += nLanes) {
+        Lanes x, y, z;
+        Load3(v+i, x, y, z);
+        Lanes s = InvLength(MulAdd(x, x, MulAdd(y, y, Mul(z, z))));
+        Store3(v+i, Mul(x, s), Mul(y, s), Mul(z, s));
+    }
+    for (; i < n; i++) {
+        float len = length(v[i]);
+        if (len > 0)
+            v[i] = v[i]/len;
+    }
+}
+
+// benchmark
+
+static float MaxError(const float *a, const float *b, int n) {
+    // largest difference relative to magnitude (at least 1)
+    float e = 0;
+    for (int i = 0; i < n; i++) {
+        float d = fabsf(a[i]-b[i])/fmaxf(1, fabsf(a[i]));
+        e = d > e? d : e;
+    }
+    return e;
+}
+
+void BenchmarkVecBatch(int n, int nRuns) {
+    // random points in +/-1 and matrices with entries in +/-1
+    Random random;
+    int nMats = n/16 > 0? n/16 : 1;
+    vector<vec3> a(n), b(n), r3(n), s3(n);
+    vector<vec4> r4(n), s4(n);
+    vector<mat4> mats(nMats), rm(nMats), sm(nMats);
+    vector<float> x(n), y(n), z(n), ox(n), oy(n), oz(n), ow(n);
+    for (int i = 0; i < n; i++) {
+        a[i] = vec3(random(), random(), random());
+        b[i] = vec3(random(), random(), random());
+        x[i] = a[i].x;
+        y[i] = a[i].y;
+        z[i] = a[i].z;
+    }
+    for (mat4 &m : mats)
+        for (int k = 0; k < 16; k++)
+            m.row[k/4][k%4] = random();
+    mat4 m = mats[0];
+    struct Result { const char *name; float scalar, batch, error; };
+    vector<Result> results;
+    // mat4*vec4(p, 1), AoS and SoA
+    float scalar = MinTime(nRuns, [&]() {
+        for (int i = 0; i < n; i++)
+            r4[i] = m*vec4(a[i].x, a[i].y, a[i].z, 1);
+    });
+    float batch = MinTime(nRuns, [&]() { TransformPoints(m, a.data(), s4.data(), n); });
+    results.push_back({"transform_points", scalar, batch, MaxError(&r4[0].x, &s4[0].x, 4*n)});
+    batch = MinTime(nRuns, [&]() { TransformPoints(m, x.data(), y.data(), z.data(), ox.data(), oy.data(), oz.data(), ow.data(), n); });
+    for (int i = 0; i < n; i++)
+        s4[i] = vec4(ox[i], oy[i], oz[i], ow[i]);
+    results.push_back({"transform_points_soa", scalar, batch, MaxError(&r4[0].x, &s4[0].x, 4*n)});
+    // mat4*mat4
+    scalar = MinTime(nRuns, [&]() {
+        for (int i = 0; i < nMats; i++)
+            rm[i] = mats[i]*mats[(i+1)%nMats];
+    });
+    batch = MinTime(nRuns, [&]() {
+        for (int i = 0; i < nMats; i++)
+            sm[i] = Multiply(mats[i], mats[(i+1)%nMats]);
+    });
+    results.push_back({"multiply", scalar, batch, MaxError(&rm[0].row[0].x, &sm[0].row[0].x, 16*nMats)});
+    // cross
+    scalar = MinTime(nRuns, [&]() {
+        for (int i = 0; i < n; i++)
+            r3[i] = cross(a[i], b[i]);
+    });
+    batch = MinTime(nRuns, [&]() { Cross(a.data(), b.data(), s3.data(), n); });
+    results.push_back({"cross", scalar, batch, MaxError(&r3[0].x, &s3[0].x, 3*n)});
+    // normalize (each run on fresh copies)
+    scalar = MinTime(nRuns, [&]() {
+        for (int i = 0; i < n; i++)
+            r3[i] = normalize(a[i]);
+    });
+    batch = MinTime(nRuns, [&]() {
+        s3 = a;
+        Normalize(s3.data(), n);
+    });
+    results.push_back({"normalize", scalar, batch, MaxError(&r3[0].x, &s3[0].x, 3*n)});
+    printf("{\n  \"n\": %d,\n  \"simd\": \"%s\",\n", n, VecBatchSimd());
+    for (size_t i = 0; i < results.size(); i++) {
+        const Result &r = results[i];
+        printf("  \"%s\": {\"scalar_ms\": %.3f, \"batch_ms\": %.3f, \"speedup\": %.2f, \"max_error\": %g}%s\n",
+               r.name, r.scalar, r.batch, r.scalar/r.batch, r.error, i+1 < results.size()? "," : "");
+    }
+    printf("}\n");
+}
@@ -0,0 +1,53 @@
+// VecBatch.h - SIMD matrix-vector kernels and batch transforms for the VecMat types
+//
+// VecMat's vec3/vec4/mat4 operators are scalar and work one value per call, so loops over
+// thousands of points (reprojecting handles, rescaling a mesh, transforming vertices)
+// pay a scalar dot product per row; here are a SIMD mat4*mat4 and batch versions of
+// mat4*vec4, cross and normalize that take whole arrays, as vec3 arrays (AoS) or as
+// separate x, y, z arrays (SoA: no shuffling)
+//
+// a single mat4*vec4 is not offered: called out of line, a SIMD version is slower than
+// VecMat's inlined one; and where memory, not arithmetic, bounds a loop (eg, transforming
+// a mesh too large for cache) batch and scalar run about even: see BenchmarkVecBatch()
+//
+// the instruction set is chosen at compile time: AVX2 with FMA (8 lanes) if the compiler
+// targets it (eg, -mavx2 -mfma, /arch:AVX2), else SSE2 or NEON (AArch64) (4 lanes), else
+// scalar; results match the VecMat operators to within float rounding
+//
+// usage:
+//     TransformPoints(camera.fullview, points.data(), clip.data(), points.size());   // vec4 out
+//     TransformPoints(m, x, y, z, ox, oy, oz, ow, n);                                 // SoA
+//     Normalize(normals.data(), normals.size());
+
+#ifndef VEC_BATCH_HDR
+#define VEC_BATCH_HDR
+
+#include "VecMat.h"
+
+const char *VecBatchSimd();
+    // "avx2", "sse2", "neon" or "none"
+
+mat4 Multiply(const mat4 &a, const mat4 &b);
+    // a*b
+
+// arrays (in and out may not overlap, except for in-place Normalize)
+
+void TransformPoints(const mat4 &m, const vec3 *points, vec4 *out, int n);
+    // out[i] = m*vec4(points[i], 1)
+void TransformPoints(const mat4 &m, const vec3 *points, vec3 *out, int n);
+    // as above, keeping x, y, z (for affine m, eg a modelview or Scale()*Translate())
+void TransformVectors(const mat4 &m, const vec3 *vectors, vec3 *out, int n);
+    // out[i] = (m*vec4(vectors[i], 0)).xyz
+void TransformPoints(const mat4 &m, const float *x, const float *y, const float *z,
+                     float *ox, float *oy, float *oz, float *ow, int n);
+    // SoA form of m*vec4(x, y, z, 1); ow may be NULL
+void Cross(const vec3 *a, const vec3 *b, vec3 *out, int n);
+    // out[i] = cross(a[i], b[i])
+void Normalize(vec3 *v, int n);
+    // in place; zero-length vectors are left as is
+
+void BenchmarkVecBatch(int n = 1 << 14, int nRuns = 200);
+    // time the VecMat operators against the above on n random values (by default,
+    // few enough to stay in cache, so arithmetic rather than memory is timed), print JSON
+
+#endif